@@ -101,3 +101,69 @@ bool queue_pop(queue_t *q, void **elem) {
 
     return true;
 }
+
+// semaphores only go up or down by one, but sem_post only makes a system call when someone is
+// waiting, and then each one wakes somebody with an element (or room) to take
+static void sem_post_n(sem_t *sem, const int n) {
+    for (int i = 0; i < n; i++) {
+        sem_post(sem);
+    }
+}
+
+// waits for one, then takes up to n - 1 more without waiting, returns how many it got
+static int sem_wait_up_to(sem_t *sem, const int n) {
+    sem_wait(sem);
+
+    int got = 1;
+    while (got < n && sem_trywait(sem) == 0) {
+        got++;
+    }
+    return got;
+}
+
+bool queue_push_many(queue_t *q, void **elems, int n) {
+    if (q == NULL || n < 0) {
+        return false;
+    }
+
+    int pushed = 0;
+    while (pushed < n) {
+        // as much room as there is now, in one go
+        const int count = sem_wait_up_to(&q->wr_sem, n - pushed);
+
+        pthread_mutex_lock(&q->wr_lock);
+
+        for (int i = 0; i < count; i++) {
+            q->buf[q->head++] = elems[pushed + i];
+            q->head %= q->size;
+        }
+
+        pthread_mutex_unlock(&q->wr_lock);
+
+        sem_post_n(&q->rd_sem, count);
+        pushed += count;
+    }
+
+    return true;
+}
+
+int queue_pop_many(queue_t *q, void **elems, int n) {
+    if (q == NULL || n <= 0) {
+        return 0;
+    }
+
+    const int count = sem_wait_up_to(&q->rd_sem, n);
+
+    pthread_mutex_lock(&q->rd_lock);
+
+    for (int i = 0; i < count; i++) {
+        elems[i] = q->buf[q->tail++];
+        q->tail %= q->size;
+    }
+
+    pthread_mutex_unlock(&q->rd_lock);
+
+    sem_post_n(&q->wr_sem, count);
+
+    return count;
+}
@@ -58,3 +58,42 @@ bool queue_push(queue_t *q, void *elem);
  *          should succeed unless the q parameter is NULL.
  */
 bool queue_pop(queue_t *q, void **elem);
+
+/** @brief push several elements onto a queue, in order, blocking
+ *         until all of them are in.
+ *
+ *  Moves as many elements at once as there is room for, taking the
+ *  lock (or, in queue_lockfree.c, claiming the positions) once per
+ *  such run rather than once per element.  queue_lockfree.c also
+ *  wakes the poppers with one system call per run, while queue.c
+ *  still posts its semaphore once per element.
+ *
+ *  @param q the queue to push the elements into.
+ *
+ *  @param elems the elements to add to the queue.
+ *
+ *  @param n how many elements there are.
+ *
+ *  @return A bool indicating success or failure.  Note, the function
+ *          should succeed unless the q parameter is NULL or n is
+ *          negative.
+ */
+bool queue_push_many(queue_t *q, void **elems, int n);
+
+/** @brief pop up to n elements from a queue, blocking until there is
+ *         at least one.
+ *
+ *  Takes whatever is there (up to n), taking the lock (or claiming
+ *  the positions) once.  Waking the pushers works as for
+ *  queue_push_many.
+ *
+ *  @param q the queue to pop the elements from.
+ *
+ *  @param elems a place to assign the popped elements, in order.
+ *
+ *  @param n the most elements to pop.
+ *
+ *  @return The number of elements popped, at least 1, or 0 if the q
+ *          parameter is NULL or n is not positive.
+ */
+int queue_pop_many(queue_t *q, void **elems, int n);
@@ -0,0 +1,132 @@
+// pushes elements through a queue from several producer threads to several consumer threads,
+// reporting ns per element, and checking every element came out exactly once
+//
+// the same source is built against each implementation of queue.h (see the Makefile):
+//   ./queue_bench [producers] [consumers] [capacity] [elements per producer] [batch]
+//
+// with a batch above 1, elements move with queue_push_many and queue_pop_many, that many at a time
+
+#include "queue.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static queue_t *q;
+static long per_producer;
+static int batch;
+
+typedef struct {
+    int id;
+    // what a consumer popped: how many, and the sum of them
+    long count;
+    uint64_t sum;
+} worker_t;
+
+static void *producer(void *arg) {
+    const worker_t *w = arg;
+    void *elems[batch];
+    int n = 0;
+
+    for (long i = 0; i < per_producer; i++) {
+        // never NULL, that is the end of the stream
+        const uintptr_t elem = ((uintptr_t) w->id << 40) + i + 1;
+        if (batch == 1) {
+            queue_push(q, (void *) elem);
+            continue;
+        }
+
+        elems[n++] = (void *) elem;
+        if (n == batch || i == per_producer - 1) {
+            queue_push_many(q, elems, n);
+            n = 0;
+        }
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    worker_t *w = arg;
+    void *elems[batch];
+    int ends = 0;
+
+    while (ends == 0) {
+        const int n = batch == 1 ? queue_pop(q, elems) : queue_pop_many(q, elems, batch);
+        for (int i = 0; i < n; i++) {
+            if (elems[i] == NULL) {
+                ends++;
+                continue;
+            }
+            w->count++;
+            w->sum += (uintptr_t) elems[i];
+        }
+    }
+
+    // ends of stream taken with ours belong to the other consumers
+    for (; ends > 1; ends--) {
+        queue_push(q, NULL);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    const int producers = argc > 1 ? atoi(argv[1]) : 4;
+    const int consumers = argc > 2 ? atoi(argv[2]) : 4;
+    const int capacity = argc > 3 ? atoi(argv[3]) : 64;
+    per_producer = argc > 4 ? atol(argv[4]) : 1000000;
+    batch = argc > 5 ? atoi(argv[5]) : 1;
+
+    if (producers <= 0 || consumers <= 0 || capacity <= 0 || per_producer <= 0 || batch <= 0) {
+        fprintf(stderr,
+            "usage: %s [producers] [consumers] [capacity] [elements per producer] [batch]\n",
+            argv[0]);
+        return 1;
+    }
+
+    q = queue_new(capacity);
+
+    pthread_t threads[producers + consumers];
+    worker_t workers[producers + consumers];
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int i = 0; i < producers + consumers; i++) {
+        workers[i] = (worker_t) {.id = i < producers ? i : i - producers};
+        pthread_create(&threads[i], NULL, i < producers ? producer : consumer, &workers[i]);
+    }
+
+    for (int i = 0; i < producers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    // one end of stream for every consumer
+    for (int i = 0; i < consumers; i++) {
+        queue_push(q, NULL);
+    }
+    for (int i = producers; i < producers + consumers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    long count = 0;
+    uint64_t sum = 0, want = 0;
+    for (int i = producers; i < producers + consumers; i++) {
+        count += workers[i].count;
+        sum += workers[i].sum;
+    }
+    for (int p = 0; p < producers; p++) {
+        want += ((uint64_t) p << 40) * per_producer + per_producer * (per_producer + 1) / 2;
+    }
+
+    const long total = producers * per_producer;
+    const double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    printf("%d producers, %d consumers, capacity %d, batch %d: %ld elements, %.1f ns/element, %s\n",
+        producers, consumers, capacity, batch, total, ns / total,
+        count == total && sum == want ? "ok" : "MISMATCH");
+
+    queue_delete(&q);
+    return count == total && sum == want ? 0 : 1;
+}
@@ -0,0 +1,347 @@
+// a lock-free implementation of queue.h, see queue.c for the one with locks and semaphores
+//
+// a bounded ring of cells, each with a sequence number that says whose turn the cell is
+// (Dmitry Vyukov's MPMC queue): a pusher claims position pos when its cell's sequence is pos,
+// and hands it to the popper of pos by setting it to pos + 1; the popper hands it back to the
+// pusher of the next lap by setting it to pos + size. claiming a position is one CAS, nobody ever
+// waits for a lock. threads only sleep (on a futex) when the ring is empty or full.
+//
+// the bulk operations claim a run of positions with one CAS instead, sized from the other end's
+// position, then wait (briefly) for each cell of the run to be handed over.
+
+#include "queue.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+// keeps what pushers and poppers write apart, so they don't fight over cache lines
+#define CACHE_LINE 64
+
+// how many times an empty or full ring is checked again before going to sleep, with more than one
+// CPU. with one, whoever would change it can't run while we spin, so we sleep right away
+#define SPINS 100
+
+typedef struct {
+    atomic_size_t seq;
+    void *elem;
+} cell_t;
+
+// what waiting threads sleep on: a counter bumped on every wakeup, and how many are asleep
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_uint seq;
+    atomic_int waiters;
+} waitq_t;
+
+struct queue {
+    // capacity of the queue
+    size_t size;
+    cell_t *cells;
+    int spins;
+
+    // the next position to push to and to pop from
+    _Alignas(CACHE_LINE) atomic_size_t push_pos;
+    _Alignas(CACHE_LINE) atomic_size_t pop_pos;
+
+    // poppers waiting for an element, and pushers waiting for room
+    waitq_t not_empty;
+    waitq_t not_full;
+};
+
+// returns after at most timeout even with no wake
+static void futex_wait(atomic_uint *addr, const unsigned val, const struct timespec *timeout) {
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, timeout, NULL, 0);
+}
+
+static void futex_wake(atomic_uint *addr, const int count) {
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+// wakes up to count threads waiting on w, with one system call if there are any
+// costs a load when nobody waits, so the fast path never makes a system call
+static void wake(waitq_t *w, const int count) {
+    if (atomic_load(&w->waiters) > 0) {
+        atomic_fetch_add(&w->seq, 1);
+        futex_wake(&w->seq, count);
+    }
+}
+
+// announces a thread about to sleep on w, returns what to pass to wait_finish
+// the counter is read before announcing ourselves, so a wake that comes after the caller checks
+// again changes it and the wait returns right away. a push or pop before that check is either seen
+// by the check, or sees us waiting: the fence orders our announcement before the check, like the
+// claiming CAS (seq_cst) orders a push or pop before it looks for waiters
+static unsigned wait_prepare(waitq_t *w) {
+    const unsigned seq = atomic_load(&w->seq);
+    atomic_fetch_add(&w->waiters, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    return seq;
+}
+
+// sleeps on w if the caller's check after wait_prepare failed, and retracts the announcement
+// a cancellation point, like the sem_wait of queue.c: pools of threads blocked in queue_pop are
+// stopped with pthread_cancel, and a raw futex call isn't one. so the sleep is bounded and checks
+// for a cancel after it, the callers just check the queue again when it times out
+static void wait_finish(waitq_t *w, const unsigned seq, const bool sleep) {
+    static const struct timespec CANCEL_CHECK = {.tv_nsec = 100 * 1000 * 1000};
+
+    if (sleep) {
+        futex_wait(&w->seq, seq, &CANCEL_CHECK);
+    }
+    atomic_fetch_sub(&w->waiters, 1);
+    if (sleep) {
+        pthread_testcancel();
+    }
+}
+
+static bool try_push(queue_t *q, void *elem) {
+    size_t pos = atomic_load_explicit(&q->push_pos, memory_order_relaxed);
+
+    while (true) {
+        cell_t *cell = &q->cells[pos % q->size];
+        const size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        const intptr_t dif = (intptr_t) seq - (intptr_t) pos;
+
+        if (dif == 0) {
+            // the cell is free for this lap, claim it
+            if (atomic_compare_exchange_weak_explicit(
+                    &q->push_pos, &pos, pos + 1, memory_order_seq_cst, memory_order_relaxed)) {
+                cell->elem = elem;
+                // seq_cst, so it is ordered before the check for waiting poppers
+                atomic_store(&cell->seq, pos + 1);
+                return true;
+            }
+            // pos was updated by the failed CAS
+        } else if (dif < 0) {
+            // the cell still holds the element of the last lap: full
+            return false;
+        } else {
+            // another pusher got here first
+            pos = atomic_load_explicit(&q->push_pos, memory_order_relaxed);
+        }
+    }
+}
+
+static bool try_pop(queue_t *q, void **elem) {
+    size_t pos = atomic_load_explicit(&q->pop_pos, memory_order_relaxed);
+
+    while (true) {
+        cell_t *cell = &q->cells[pos % q->size];
+        const size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        const intptr_t dif = (intptr_t) seq - (intptr_t) (pos + 1);
+
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(
+                    &q->pop_pos, &pos, pos + 1, memory_order_seq_cst, memory_order_relaxed)) {
+                *elem = cell->elem;
+                // hand the cell to the pusher of the next lap
+                atomic_store(&cell->seq, pos + q->size);
+                return true;
+            }
+        } else if (dif < 0) {
+            // nothing pushed here yet: empty
+            return false;
+        } else {
+            pos = atomic_load_explicit(&q->pop_pos, memory_order_relaxed);
+        }
+    }
+}
+
+// pushes as many of the n elements as there is room for, returns how many
+static int try_push_many(queue_t *q, void **elems, const int n) {
+    size_t pos = atomic_load_explicit(&q->push_pos, memory_order_relaxed);
+    size_t count;
+
+    do {
+        // pop_pos only grows, so this never overestimates the room
+        const size_t popped = atomic_load_explicit(&q->pop_pos, memory_order_acquire);
+        const intptr_t room = (intptr_t) (popped + q->size - pos);
+        if (room <= 0) {
+            return 0;
+        }
+        count = (size_t) room < (size_t) n ? (size_t) room : (size_t) n;
+        // on failure pos is updated, and the room is worked out again
+    } while (!atomic_compare_exchange_weak_explicit(
+        &q->push_pos, &pos, pos + count, memory_order_seq_cst, memory_order_relaxed));
+
+    for (size_t i = 0; i < count; i++) {
+        cell_t *cell = &q->cells[(pos + i) % q->size];
+        // the popper of the last lap may have claimed the cell but not handed it back yet
+        while (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + i) {
+            sched_yield();
+        }
+        cell->elem = elems[i];
+        atomic_store(&cell->seq, pos + i + 1);
+    }
+
+    return count;
+}
+
+// pops up to n elements, returns how many
+static int try_pop_many(queue_t *q, void **elems, const int n) {
+    size_t pos = atomic_load_explicit(&q->pop_pos, memory_order_relaxed);
+    size_t count;
+
+    do {
+        const size_t pushed = atomic_load_explicit(&q->push_pos, memory_order_acquire);
+        const intptr_t avail = (intptr_t) (pushed - pos);
+        if (avail <= 0) {
+            return 0;
+        }
+        count = (size_t) avail < (size_t) n ? (size_t) avail : (size_t) n;
+    } while (!atomic_compare_exchange_weak_explicit(
+        &q->pop_pos, &pos, pos + count, memory_order_seq_cst, memory_order_relaxed));
+
+    for (size_t i = 0; i < count; i++) {
+        cell_t *cell = &q->cells[(pos + i) % q->size];
+        // the pusher may have claimed the cell but not filled it yet
+        while (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + i + 1) {
+            sched_yield();
+        }
+        elems[i] = cell->elem;
+        atomic_store(&cell->seq, pos + i + q->size);
+    }
+
+    return count;
+}
+
+queue_t *queue_new(int size) {
+    if (size <= 0) {
+        // bad queue size, return NULL
+        return NULL;
+    }
+
+    queue_t *q = aligned_alloc(CACHE_LINE, sizeof(queue_t));
+    q->size = size;
+    q->cells = malloc(size * sizeof(cell_t));
+    q->spins = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SPINS : 0;
+
+    for (int i = 0; i < size; i++) {
+        atomic_init(&q->cells[i].seq, i);
+    }
+    atomic_init(&q->push_pos, 0);
+    atomic_init(&q->pop_pos, 0);
+    atomic_init(&q->not_empty.seq, 0);
+    atomic_init(&q->not_empty.waiters, 0);
+    atomic_init(&q->not_full.seq, 0);
+    atomic_init(&q->not_full.waiters, 0);
+
+    return q;
+}
+
+void queue_delete(queue_t **q) {
+    if (q == NULL || *q == NULL) {
+        return;
+    }
+
+    free((*q)->cells);
+    free(*q);
+
+    *q = NULL;
+}
+
+bool queue_push(queue_t *q, void *elem) {
+    if (q == NULL) {
+        return false;
+    }
+
+    for (int spin = 0; !try_push(q, elem); spin++) {
+        if (spin < q->spins) {
+            continue;
+        }
+
+        // full, sleep until a pop makes room
+        const unsigned seq = wait_prepare(&q->not_full);
+        const bool pushed = try_push(q, elem);
+        wait_finish(&q->not_full, seq, !pushed);
+        if (pushed) {
+            break;
+        }
+    }
+
+    wake(&q->not_empty, 1);
+    return true;
+}
+
+bool queue_pop(queue_t *q, void **elem) {
+    if (q == NULL) {
+        return false;
+    }
+
+    for (int spin = 0; !try_pop(q, elem); spin++) {
+        if (spin < q->spins) {
+            continue;
+        }
+
+        // empty, sleep until a push
+        const unsigned seq = wait_prepare(&q->not_empty);
+        const bool popped = try_pop(q, elem);
+        wait_finish(&q->not_empty, seq, !popped);
+        if (popped) {
+            break;
+        }
+    }
+
+    wake(&q->not_full, 1);
+    return true;
+}
+
+bool queue_push_many(queue_t *q, void **elems, int n) {
+    if (q == NULL || n < 0) {
+        return false;
+    }
+
+    int pushed = 0;
+    int spin = 0;
+    while (pushed < n) {
+        int count = try_push_many(q, elems + pushed, n - pushed);
+
+        if (count == 0 && spin++ >= q->spins) {
+            // full, sleep until a pop makes room
+            const unsigned seq = wait_prepare(&q->not_full);
+            count = try_push_many(q, elems + pushed, n - pushed);
+            wait_finish(&q->not_full, seq, count == 0);
+        }
+
+        if (count > 0) {
+            // one wakeup for the whole run
+            wake(&q->not_empty, count);
+            pushed += count;
+            spin = 0;
+        }
+    }
+
+    return true;
+}
+
+int queue_pop_many(queue_t *q, void **elems, int n) {
+    if (q == NULL || n <= 0) {
+        return 0;
+    }
+
+    int count;
+    for (int spin = 0; (count = try_pop_many(q, elems, n)) == 0; spin++) {
+        if (spin < q->spins) {
+            continue;
+        }
+
+        // empty, sleep until a push
+        const unsigned seq = wait_prepare(&q->not_empty);
+        count = try_pop_many(q, elems, n);
+        wait_finish(&q->not_empty, seq, count == 0);
+        if (count > 0) {
+            break;
+        }
+    }
+
+    wake(&q->not_full, count);
+    return count;
+}
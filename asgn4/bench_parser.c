@@ -0,0 +1,132 @@
+/**
+ * @file bench_parser.c
+ *
+ * Benchmark for the request parser, built with `make bench_parser`
+ *
+ * Replays a corpus of raw requests through req_create_from_buffer and req_parse, and reports
+ * the time and number of heap allocations per request, so parser changes can be measured
+ * without any sockets involved.
+ *
+ * Usage: ./bench_parser [-n iterations] [request files...]
+ * With no files, the requests in corpus/ are used.
+ *
+ * @author Sebastian Law
+*/
+
+#include "seb_http.h"
+
+#include <glob.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+// the benchmark is linked with --wrap for each of these, so every allocation is counted
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static unsigned long allocs = 0;
+
+void *__wrap_malloc(size_t size) {
+    allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    allocs++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    allocs++;
+    return __real_realloc(ptr, size);
+}
+
+static char *read_file(const char *path, size_t *n) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+
+    static char buf[1 << 16];
+    *n = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    return buf;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench(const char *path, const long iterations, double *total_ns, long *total_reqs) {
+    size_t n;
+    const char *data = read_file(path, &n);
+    if (data == NULL) {
+        fprintf(stderr, "Failed to read %s\n", path);
+        return;
+    }
+
+    int res = 0;
+    const unsigned long allocs_before = allocs;
+    const double start = now_ns();
+
+    for (long i = 0; i < iterations; i++) {
+        Request *req = req_create_from_buffer(data, n);
+        res = req_parse(req);
+        req_free(req);
+    }
+
+    const double elapsed = now_ns() - start;
+    const unsigned long n_allocs = allocs - allocs_before;
+
+    printf("%-32s %6zu bytes %10.1f ns/req %6.2f allocs/req %s\n", path, n,
+        elapsed / iterations, (double) n_allocs / iterations, res == 0 ? "valid" : "invalid");
+
+    *total_ns += elapsed;
+    *total_reqs += iterations;
+}
+
+int main(const int argc, char *const argv[]) {
+    long iterations = 200000;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            if (sscanf(optarg, "%ld", &iterations) != 1 || iterations <= 0) {
+                fprintf(stderr, "Invalid iteration count: %s\n", optarg);
+                return 1;
+            }
+            break;
+        default: fprintf(stderr, "Usage: %s [-n iterations] [request files...]\n", argv[0]); return 1;
+        }
+    }
+
+    double total_ns = 0;
+    long total_reqs = 0;
+
+    if (optind < argc) {
+        for (int i = optind; i < argc; i++) {
+            bench(argv[i], iterations, &total_ns, &total_reqs);
+        }
+    } else {
+        glob_t g;
+        if (glob("corpus/*", 0, NULL, &g) != 0) {
+            fprintf(stderr, "No request files given and corpus/ is empty\n");
+            return 1;
+        }
+        for (size_t i = 0; i < g.gl_pathc; i++) {
+            bench(g.gl_pathv[i], iterations, &total_ns, &total_reqs);
+        }
+        globfree(&g);
+    }
+
+    if (total_reqs > 0) {
+        printf("%-32s %18.1f ns/req\n", "mean", total_ns / total_reqs);
+    }
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file bench_send.c
+ *
+ * Benchmark for the ways a GET can send a file, built with `make bench_send`
+ *
+ * Sends files of several sizes over a loopback TCP connection (drained by another thread) with
+ * pass_n_bytes (the old read/write loop), io_send_file (sendfile) and io_send_mapped (mmap),
+ * and reports the throughput of each, to pick the mmap threshold (httpserver -m).
+ *
+ * Usage: ./bench_send [-d dir] [-r repetitions]
+ * The test files are created in dir (default /tmp) and removed afterwards.
+ *
+ * @author Sebastian Law
+*/
+
+#include "asgn2_helper_funcs.h"
+#include "seb_io.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static const size_t sizes[] = {4 << 10, 64 << 10, 1 << 20, 16 << 20, 128 << 20};
+#define NUM_SIZES (sizeof(sizes) / sizeof(sizes[0]))
+
+static const char *const method_names[] = {"pass_n_bytes", "sendfile", "mmap"};
+#define NUM_METHODS 3
+
+static void *drain_thread(void *arg) {
+    const int fd = *(int *) arg;
+    static char buf[1 << 16];
+    while (read(fd, buf, sizeof(buf)) > 0) {
+    }
+    return NULL;
+}
+
+// connects a pair of loopback TCP sockets
+static void tcp_pair(int *client, int *server) {
+    const int lfd = socket(AF_INET, SOCK_STREAM, 0);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+
+    if (bind(lfd, (struct sockaddr *) &addr, sizeof(addr)) == -1 || listen(lfd, 1) == -1
+        || getsockname(lfd, (struct sockaddr *) &addr, &len) == -1) {
+        perror("listen");
+        exit(1);
+    }
+
+    *client = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(*client, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+        perror("connect");
+        exit(1);
+    }
+    *server = accept(lfd, NULL, NULL);
+    close(lfd);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void send_with(const int method, const int sock, const int fd, const size_t n) {
+    switch (method) {
+    case 0:
+        lseek(fd, 0, SEEK_SET);
+        pass_n_bytes(fd, sock, n);
+        break;
+    case 1: io_send_file(sock, fd, 0, n); break;
+    case 2: io_send_mapped(sock, fd, 0, n); break;
+    }
+}
+
+int main(const int argc, char *const argv[]) {
+    const char *dir = "/tmp";
+    long reps = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:r:")) != -1) {
+        switch (opt) {
+        case 'd': dir = optarg; break;
+        case 'r':
+            if (sscanf(optarg, "%ld", &reps) != 1 || reps <= 0) {
+                fprintf(stderr, "Invalid repetition count: %s\n", optarg);
+                return 1;
+            }
+            break;
+        default: fprintf(stderr, "Usage: %s [-d dir] [-r repetitions]\n", argv[0]); return 1;
+        }
+    }
+
+    int client, sock;
+    tcp_pair(&client, &sock);
+
+    pthread_t drainer;
+    pthread_create(&drainer, NULL, drain_thread, &client);
+
+    printf("%10s", "bytes");
+    for (int m = 0; m < NUM_METHODS; m++) {
+        printf(" %14s", method_names[m]);
+    }
+    printf("   (MB/s)\n");
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/bench_send.XXXXXX", dir);
+    const int fd = mkstemp(path);
+    if (fd == -1) {
+        perror(path);
+        return 1;
+    }
+    unlink(path);
+
+    static char block[1 << 16];
+    memset(block, 'x', sizeof(block));
+
+    for (size_t s = 0; s < NUM_SIZES; s++) {
+        const size_t n = sizes[s];
+
+        // fill the file, it stays in the page cache so this measures the send path only
+        ftruncate(fd, 0);
+        for (size_t w = 0; w < n; w += sizeof(block)) {
+            write_n_bytes(fd, block, n - w < sizeof(block) ? n - w : sizeof(block));
+        }
+
+        // send about 1 GB per measurement unless told otherwise
+        const long r = reps > 0 ? reps : (long) ((1 << 30) / n) + 1;
+
+        printf("%10zu", n);
+        for (int m = 0; m < NUM_METHODS; m++) {
+            // warm up once
+            send_with(m, sock, fd, n);
+
+            const double start = now_s();
+            for (long i = 0; i < r; i++) {
+                send_with(m, sock, fd, n);
+            }
+            const double elapsed = now_s() - start;
+
+            printf(" %14.1f", (double) n * r / elapsed / 1e6);
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+
+    close(fd);
+    shutdown(sock, SHUT_WR);
+    pthread_join(drainer, NULL);
+    close(sock);
+    close(client);
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file fuzz_parser.c
+ *
+ * libFuzzer harness for the request parser, built with `make fuzz_parser`
+ *
+ * Run it with the request corpus as a seed: ./fuzz_parser corpus/
+ *
+ * @author Sebastian Law
+*/
+
+#include "seb_http.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    Request *req = req_create_from_buffer((const char *) data, size);
+
+    if (req_parse(req) == 0) {
+        // touch everything the parser produced, so the sanitizers see any bad views
+        volatile size_t sink = strlen(req_get_uri(req));
+
+        const Header *headers = req_get_headers(req);
+        for (int i = 0; i < req_get_num_headers(req); i++) {
+            sink += strlen(req_get_header_key(req, &headers[i]));
+            sink += strlen(req_get_header_value_of(req, &headers[i]));
+        }
+
+        sink += req_get_content_length(req);
+
+        const char *body = req_get_body(req);
+        for (bufsize_t i = 0; i < req_get_body_size(req); i++) {
+            sink += body[i];
+        }
+    }
+
+    req_free(req);
+    return 0;
+}
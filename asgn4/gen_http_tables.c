@@ -0,0 +1,650 @@
+/**
+ * @file gen_http_tables.c
+ *
+ * Build-time generator for seb_http_tables.h
+ *
+ * Compiles _REQUEST_PATTERN from seb_http_grammar.h into a DFA (regex -> Thompson NFA -> subset
+ * construction) and prints its tables as C source on stdout. Only the parts of POSIX extended
+ * regular expressions that the grammar uses are supported: literals, escapes, bracket expressions,
+ * capture groups, and the *, +, ? and {m,n} quantifiers.
+ *
+ * It also finds a perfect hash for the KNOWN_HEADERS in seb_http.h, so the parser can classify
+ * header keys with one table lookup and one comparison.
+ *
+ * @author Sebastian Law
+*/
+
+#include "seb_http.h"
+#include "seb_http_grammar.h"
+#include "seb_scan.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_NFA_STATES 8192
+#define MAX_DFA_STATES 4096
+#define MAX_SETS       64
+
+#define SET_WORDS (MAX_NFA_STATES / 64)
+
+_Noreturn static void die(const char *msg) {
+    fprintf(stderr, "gen_http_tables: %s\n", msg);
+    exit(1);
+}
+
+// regex parsing
+
+typedef enum {
+    NODE_SET,
+    NODE_CAT,
+    NODE_GROUP,
+    NODE_REPEAT,
+} NodeType;
+
+typedef struct node {
+    NodeType type;
+
+    // NODE_SET: index into the byte set table
+    int set;
+
+    // NODE_CAT: the sequence of children
+    // NODE_GROUP, NODE_REPEAT: the child is kids[0]
+    struct node **kids;
+    int n_kids;
+
+    // NODE_GROUP: the capture group number, starting at 1
+    int group;
+
+    // NODE_REPEAT: bounds, max is -1 if unbounded
+    int min;
+    int max;
+} Node;
+
+// every distinct bracket expression or literal gets a byte set
+static bool sets[MAX_SETS][256];
+static int n_sets = 0;
+
+static const char *p;
+static int n_groups = 0;
+
+static Node *new_node(const NodeType type) {
+    Node *n = calloc(1, sizeof(Node));
+    n->type = type;
+    return n;
+}
+
+static void add_kid(Node *parent, Node *kid) {
+    parent->kids = realloc(parent->kids, (parent->n_kids + 1) * sizeof(Node *));
+    parent->kids[parent->n_kids++] = kid;
+}
+
+static Node *new_set(void) {
+    if (n_sets == MAX_SETS) {
+        die("too many byte sets");
+    }
+
+    Node *n = new_node(NODE_SET);
+    n->set = n_sets++;
+    return n;
+}
+
+static Node *parse_seq(void);
+
+// POSIX bracket expression, note that a backslash is a literal inside brackets
+static Node *parse_bracket(void) {
+    Node *n = new_set();
+
+    if (*p == '^') {
+        die("negated bracket expressions are not supported");
+    }
+
+    bool first = true;
+    while (*p != ']' || first) {
+        if (*p == '\0') {
+            die("unterminated bracket expression");
+        }
+
+        const unsigned char lo = *p++;
+        unsigned char hi = lo;
+        if (p[0] == '-' && p[1] != ']' && p[1] != '\0') {
+            hi = p[1];
+            p += 2;
+        }
+
+        for (int c = lo; c <= hi; c++) {
+            sets[n->set][c] = true;
+        }
+        first = false;
+    }
+    p++; // ]
+
+    return n;
+}
+
+static Node *parse_atom(void) {
+    Node *n;
+
+    switch (*p) {
+    case '(':
+        p++;
+        n = new_node(NODE_GROUP);
+        n->group = ++n_groups;
+        add_kid(n, parse_seq());
+        if (*p++ != ')') {
+            die("unbalanced parenthesis");
+        }
+        return n;
+    case '[': p++; return parse_bracket();
+    case '\\':
+        p++;
+        if (*p == '\0') {
+            die("trailing backslash");
+        }
+        break;
+    case '|':
+    case '^':
+    case '$':
+    case '.': die("unsupported operator");
+    default: break;
+    }
+
+    n = new_set();
+    sets[n->set][(unsigned char) *p++] = true;
+    return n;
+}
+
+static int parse_int(void) {
+    if (*p < '0' || *p > '9') {
+        die("expected a number in bound");
+    }
+
+    int res = 0;
+    while (*p >= '0' && *p <= '9') {
+        res = res * 10 + (*p++ - '0');
+    }
+    return res;
+}
+
+static Node *parse_quant(Node *atom) {
+    int min, max;
+
+    switch (*p) {
+    case '*': min = 0, max = -1; break;
+    case '+': min = 1, max = -1; break;
+    case '?': min = 0, max = 1; break;
+    case '{':
+        p++;
+        min = max = parse_int();
+        if (*p == ',') {
+            p++;
+            max = *p == '}' ? -1 : parse_int();
+        }
+        if (*p != '}' || (max != -1 && max < min)) {
+            die("bad bound");
+        }
+        break;
+    default: return atom;
+    }
+    p++;
+
+    Node *n = new_node(NODE_REPEAT);
+    n->min = min;
+    n->max = max;
+    add_kid(n, atom);
+    return n;
+}
+
+static Node *parse_seq(void) {
+    Node *n = new_node(NODE_CAT);
+    while (*p != '\0' && *p != ')') {
+        add_kid(n, parse_quant(parse_atom()));
+    }
+    return n;
+}
+
+// Thompson NFA construction
+
+typedef struct {
+    // epsilon transitions
+    int eps[2];
+    int n_eps;
+
+    // byte transition, set is -1 if there is none
+    int set;
+    int next;
+    // the capture group the byte transition is in
+    int tag;
+} NState;
+
+static NState nfa[MAX_NFA_STATES];
+static int n_nfa = 0;
+
+typedef struct {
+    int start;
+    int end;
+} Frag;
+
+static int nfa_new(void) {
+    if (n_nfa == MAX_NFA_STATES) {
+        die("too many NFA states");
+    }
+
+    nfa[n_nfa].n_eps = 0;
+    nfa[n_nfa].set = -1;
+    return n_nfa++;
+}
+
+static void nfa_eps(const int from, const int to) {
+    if (nfa[from].n_eps == 2) {
+        die("NFA state has too many epsilon transitions");
+    }
+    nfa[from].eps[nfa[from].n_eps++] = to;
+}
+
+static Frag build(const Node *n, const int tag) {
+    Frag f, k;
+    int cur;
+
+    switch (n->type) {
+    case NODE_SET:
+        f.start = nfa_new();
+        f.end = nfa_new();
+        nfa[f.start].set = n->set;
+        nfa[f.start].next = f.end;
+        nfa[f.start].tag = tag;
+        return f;
+
+    case NODE_CAT:
+        f.start = f.end = nfa_new();
+        for (int i = 0; i < n->n_kids; i++) {
+            k = build(n->kids[i], tag);
+            nfa_eps(f.end, k.start);
+            f.end = k.end;
+        }
+        return f;
+
+    case NODE_GROUP: return build(n->kids[0], n->group);
+
+    case NODE_REPEAT:
+        f.start = cur = nfa_new();
+        f.end = nfa_new();
+
+        for (int i = 0; i < n->min; i++) {
+            k = build(n->kids[0], tag);
+            nfa_eps(cur, k.start);
+            cur = k.end;
+        }
+
+        if (n->max == -1) {
+            const int loop = nfa_new();
+            k = build(n->kids[0], tag);
+            nfa_eps(cur, loop);
+            nfa_eps(loop, k.start);
+            nfa_eps(loop, f.end);
+            nfa_eps(k.end, loop);
+            return f;
+        }
+
+        for (int i = n->min; i < n->max; i++) {
+            k = build(n->kids[0], tag);
+            nfa_eps(cur, k.start);
+            nfa_eps(cur, f.end);
+            cur = k.end;
+        }
+        nfa_eps(cur, f.end);
+        return f;
+    }
+
+    die("bad node");
+}
+
+// byte equivalence classes
+
+static int byte_class[256];
+static int class_rep[256];
+static int n_classes = 0;
+
+static void build_classes(void) {
+    for (int b = 0; b < 256; b++) {
+        byte_class[b] = -1;
+        for (int k = 0; k < n_classes && byte_class[b] == -1; k++) {
+            bool same = true;
+            for (int s = 0; s < n_sets && same; s++) {
+                same = sets[s][b] == sets[s][class_rep[k]];
+            }
+            if (same) {
+                byte_class[b] = k;
+            }
+        }
+
+        if (byte_class[b] == -1) {
+            class_rep[n_classes] = b;
+            byte_class[b] = n_classes++;
+        }
+    }
+}
+
+// subset construction
+
+typedef struct {
+    uint64_t bits[SET_WORDS];
+} StateSet;
+
+static StateSet *dfa_sets;
+static int (*dfa_next)[256];
+static int dfa_tag[MAX_DFA_STATES];
+static bool dfa_accept[MAX_DFA_STATES];
+static int n_dfa = 0;
+
+static void closure(StateSet *s) {
+    int stack[MAX_NFA_STATES];
+    int top = 0;
+
+    for (int i = 0; i < n_nfa; i++) {
+        if (s->bits[i / 64] & (1ULL << (i % 64))) {
+            stack[top++] = i;
+        }
+    }
+
+    while (top > 0) {
+        const int i = stack[--top];
+        for (int e = 0; e < nfa[i].n_eps; e++) {
+            const int j = nfa[i].eps[e];
+            if (!(s->bits[j / 64] & (1ULL << (j % 64)))) {
+                s->bits[j / 64] |= 1ULL << (j % 64);
+                stack[top++] = j;
+            }
+        }
+    }
+}
+
+static int dfa_find_or_add(const StateSet *s, const int tag, const int final) {
+    for (int i = 0; i < n_dfa; i++) {
+        if (memcmp(&dfa_sets[i], s, sizeof(StateSet)) == 0) {
+            if (i != 0 && dfa_tag[i] != tag) {
+                die("DFA state is reached with two different tags");
+            }
+            return i;
+        }
+    }
+
+    if (n_dfa == MAX_DFA_STATES) {
+        die("too many DFA states");
+    }
+
+    dfa_sets[n_dfa] = *s;
+    dfa_tag[n_dfa] = tag;
+    dfa_accept[n_dfa] = (s->bits[final / 64] >> (final % 64)) & 1;
+    return n_dfa++;
+}
+
+static void build_dfa(const Frag f) {
+    dfa_sets = calloc(MAX_DFA_STATES, sizeof(StateSet));
+    dfa_next = calloc(MAX_DFA_STATES, sizeof(*dfa_next));
+
+    // state 0 is the dead state (the empty set)
+    StateSet s;
+    memset(&s, 0, sizeof(s));
+    dfa_find_or_add(&s, TAG_NONE, f.end);
+
+    // state 1 is the start state
+    s.bits[f.start / 64] |= 1ULL << (f.start % 64);
+    closure(&s);
+    dfa_find_or_add(&s, TAG_NONE, f.end);
+
+    for (int d = 1; d < n_dfa; d++) {
+        for (int k = 0; k < n_classes; k++) {
+            const int b = class_rep[k];
+            int tag = -1;
+
+            memset(&s, 0, sizeof(s));
+            for (int i = 0; i < n_nfa; i++) {
+                if (!(dfa_sets[d].bits[i / 64] & (1ULL << (i % 64)))) {
+                    continue;
+                }
+                if (nfa[i].set == -1 || !sets[nfa[i].set][b]) {
+                    continue;
+                }
+                if (tag != -1 && tag != nfa[i].tag) {
+                    die("a byte can be tagged with two different groups");
+                }
+                tag = nfa[i].tag;
+                s.bits[nfa[i].next / 64] |= 1ULL << (nfa[i].next % 64);
+            }
+
+            closure(&s);
+            dfa_next[d][k] = dfa_find_or_add(&s, tag == -1 ? TAG_NONE : tag, f.end);
+        }
+
+        // the parser stops at the first accepting state, so nothing may follow one
+        for (int k = 0; k < n_classes && dfa_accept[d]; k++) {
+            if (dfa_next[d][k] != 0) {
+                die("the grammar is not prefix-free");
+            }
+        }
+    }
+}
+
+// runs
+
+// A run is a chain of states where every byte of one ScanClass moves to the next state in the
+// chain (with the same tag), and every other byte leaves it. The states of each run are numbered
+// consecutively, so the parser can skip k bytes of a run with scan_span and state += k.
+
+static int run_class[MAX_DFA_STATES];
+static int run_len[MAX_DFA_STATES];
+
+// returns the state that every byte of cls moves d to along a run, or -1
+static int run_successor(const int d, const ScanClass cls) {
+    int succ = -1;
+
+    for (int b = 0; b < 256; b++) {
+        const int next = dfa_next[d][byte_class[b]];
+        const bool in_run = next != 0 && next != d && dfa_tag[next] == dfa_tag[d];
+
+        if (scan_class_has(cls, b) != in_run || (in_run && succ != -1 && next != succ)) {
+            return -1;
+        }
+        if (in_run) {
+            succ = next;
+        }
+    }
+
+    return succ;
+}
+
+static void find_runs(void) {
+    int succ[MAX_DFA_STATES];
+
+    for (int d = 0; d < n_dfa; d++) {
+        succ[d] = -1;
+        run_class[d] = SCAN_NONE;
+        for (int cls = SCAN_NONE + 1; cls < SCAN_NUM_CLASSES && d != 0 && succ[d] == -1; cls++) {
+            succ[d] = run_successor(d, cls);
+            run_class[d] = succ[d] == -1 ? SCAN_NONE : cls;
+        }
+    }
+
+    // renumber the states so each run is consecutive, keeping the dead and start states in place
+    int new_id[MAX_DFA_STATES], old_id[MAX_DFA_STATES];
+    int placed = 0;
+
+    for (int d = 0; d < n_dfa; d++) {
+        new_id[d] = -1;
+    }
+    for (int d = 0; d < n_dfa; d++) {
+        for (int s = d; s != -1 && new_id[s] == -1; s = succ[s]) {
+            old_id[placed] = s;
+            new_id[s] = placed++;
+        }
+    }
+
+    static int next[MAX_DFA_STATES][256];
+    int tag[MAX_DFA_STATES], cls[MAX_DFA_STATES];
+    bool accept[MAX_DFA_STATES];
+
+    for (int i = 0; i < n_dfa; i++) {
+        for (int k = 0; k < n_classes; k++) {
+            next[i][k] = new_id[dfa_next[old_id[i]][k]];
+        }
+        tag[i] = dfa_tag[old_id[i]];
+        accept[i] = dfa_accept[old_id[i]];
+        cls[i] = run_class[old_id[i]];
+    }
+
+    for (int i = n_dfa - 1; i >= 0; i--) {
+        memcpy(dfa_next[i], next[i], sizeof(next[i]));
+        dfa_tag[i] = tag[i];
+        dfa_accept[i] = accept[i];
+        run_class[i] = cls[i];
+
+        // how many more bytes of the run can be consumed from here
+        const int s = succ[old_id[i]];
+        run_len[i] = 0;
+        if (s != -1 && new_id[s] == i + 1) {
+            run_len[i] = 1 + (run_class[i + 1] == run_class[i] ? run_len[i + 1] : 0);
+        }
+    }
+
+    if (old_id[0] != 0 || old_id[1] != 1) {
+        die("the dead and start states were renumbered");
+    }
+}
+
+// perfect hash of the well-known header names
+
+static const char *const known_names[HDR_NUM_KNOWN] = {
+#define NAME(id, name) name,
+    KNOWN_HEADERS(NAME)
+#undef NAME
+};
+
+// hash(len, first, last) = (len * hash_a + first * hash_b + last) & (hash_size - 1),
+// where first and last are the first and last characters of the name OR'd with 0x20
+static int hash_a, hash_b, hash_size;
+static int hash_slot[256];
+static int hash_max_len = 0;
+
+static void find_header_hash(void) {
+    for (hash_size = 8; hash_size <= 256; hash_size *= 2) {
+        for (hash_a = 1; hash_a < 64; hash_a++) {
+            for (hash_b = 0; hash_b < 64; hash_b++) {
+                bool ok = true;
+                for (int i = 0; i < hash_size; i++) {
+                    hash_slot[i] = -1;
+                }
+
+                for (int h = 0; h < HDR_NUM_KNOWN && ok; h++) {
+                    const int len = strlen(known_names[h]);
+                    const int first = known_names[h][0] | 0x20;
+                    const int last = known_names[h][len - 1] | 0x20;
+                    const int i = (len * hash_a + first * hash_b + last) & (hash_size - 1);
+
+                    ok = hash_slot[i] == -1;
+                    hash_slot[i] = h;
+                    if (len > hash_max_len) {
+                        hash_max_len = len;
+                    }
+                }
+
+                if (ok) {
+                    return;
+                }
+            }
+        }
+    }
+
+    die("no perfect hash for the well-known headers");
+}
+
+// output
+
+static void print_row(const int *row, const int n) {
+    for (int i = 0; i < n; i++) {
+        const bool eol = (i + 1) % 16 == 0 || i + 1 == n;
+        printf("%s%d,%s", i % 16 == 0 ? "    " : "", row[i], eol ? "\n" : " ");
+    }
+}
+
+int main(void) {
+    p = _REQUEST_PATTERN;
+    Node *root = parse_seq();
+    if (*p != '\0') {
+        die("unbalanced parenthesis");
+    }
+    if (n_groups != TAG_VALUE) {
+        die("the capture groups of _REQUEST_PATTERN do not match ReqTag");
+    }
+
+    const Frag f = build(root, TAG_NONE);
+    build_classes();
+    build_dfa(f);
+    find_runs();
+    find_header_hash();
+
+    printf("/**\n");
+    printf(" * @file seb_http_tables.h\n");
+    printf(" *\n");
+    printf(" * Generated by gen_http_tables from _REQUEST_PATTERN in seb_http_grammar.h, do not edit.\n");
+    printf("*/\n\n");
+    printf("#pragma once\n\n");
+    printf("#define _DFA_NUM_STATES  %d\n", n_dfa);
+    printf("#define _DFA_NUM_CLASSES %d\n", n_classes);
+    printf("#define _DFA_DEAD        0\n");
+    printf("#define _DFA_START       1\n\n");
+
+    printf("// byte -> equivalence class\n");
+    printf("static const unsigned char _dfa_class[256] = {\n");
+    print_row(byte_class, 256);
+    printf("};\n\n");
+
+    printf("// state x class -> state\n");
+    printf("static const unsigned short _dfa_next[_DFA_NUM_STATES][_DFA_NUM_CLASSES] = {\n");
+    for (int d = 0; d < n_dfa; d++) {
+        printf("    {");
+        for (int k = 0; k < n_classes; k++) {
+            printf("%d%s", dfa_next[d][k], k + 1 == n_classes ? "" : ", ");
+        }
+        printf("},\n");
+    }
+    printf("};\n\n");
+
+    int row[MAX_DFA_STATES];
+
+    printf("// the ReqTag of the byte consumed to enter each state\n");
+    printf("static const unsigned char _dfa_tag[_DFA_NUM_STATES] = {\n");
+    print_row(dfa_tag, n_dfa);
+    printf("};\n\n");
+
+    for (int d = 0; d < n_dfa; d++) {
+        row[d] = dfa_accept[d];
+    }
+    printf("// whether each state accepts\n");
+    printf("static const unsigned char _dfa_accept[_DFA_NUM_STATES] = {\n");
+    print_row(row, n_dfa);
+    printf("};\n\n");
+
+    printf("// the ScanClass of the run each state is in\n");
+    printf("static const unsigned char _dfa_run_class[_DFA_NUM_STATES] = {\n");
+    print_row(run_class, n_dfa);
+    printf("};\n\n");
+
+    printf("// how many more bytes of the run can be skipped from each state\n");
+    printf("static const unsigned char _dfa_run_len[_DFA_NUM_STATES] = {\n");
+    print_row(run_len, n_dfa);
+    printf("};\n\n");
+
+    printf("// perfect hash of the KNOWN_HEADERS names, first and last must already be OR'd with 0x20\n");
+    printf("#define _HDR_MAX_LEN %d\n", hash_max_len);
+    printf("#define _HDR_HASH(len, first, last) (((len) * %d + (first) * %d + (last)) & %d)\n\n",
+        hash_a, hash_b, hash_size - 1);
+    printf("// hash -> KnownHeader, or -1\n");
+    printf("static const signed char _hdr_slot[%d] = {\n", hash_size);
+    print_row(hash_slot, hash_size);
+    printf("};\n");
+
+    return 0;
+}
@@ -1,9 +1,20 @@
-#include "asgn2_helper_funcs.h"
+// strptime, timegm and gmtime_r are extensions
+#define _GNU_SOURCE
+
+#include "httpserver.h"
 
+#include "asgn2_helper_funcs.h"
 #include "queue.h"
 #include "rwlock.h"
+#include "seb_fdcache.h"
 #include "seb_http.h"
+#include "seb_io.h"
+#include "seb_objcache.h"
+#include "seb_reactor.h"
+#include "uring_engine.h"
 
+#include <sys/random.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <signal.h>
 #include <errno.h>
@@ -12,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <stdbool.h>
 
@@ -39,6 +51,29 @@ struct file_lock {
 
 static struct file_lock *file_locks;
 
+// GETs of files at least this large are sent from a memory mapping, -1 to never map (-m)
+static long long mmap_threshold = -1;
+// PUTs of at least this many bytes are kept out of the page cache, -1 to never (-d)
+static long long drop_cache_threshold = -1;
+// PUTs of at least this many bytes go through the pipelined copy engine, -1 to never (-p)
+static long long pipeline_threshold = -1;
+// print the throughput of every pipelined PUT on stdout (-s)
+static bool pipeline_stats = false;
+// how many files GETs keep open, 0 to open every time (-f)
+static int fd_cache_size = 256;
+// how much memory small files are cached in, 0 to never cache them (-o)
+static long long object_cache_bytes = 32 << 20;
+// how long a connection may sit idle between requests, in seconds, 0 to close after one (-k)
+static int keep_alive_secs = 5;
+// every worker accepts on a listener of its own, rather than main's reactor queueing to all (-r)
+static bool reuseport = false;
+// and each listener takes the connections received on its worker's CPU (-c)
+static bool incoming_cpu = false;
+
+// the permissions of files created by PUT, with the umask applied (set in main)
+// they start out as 0600 temporary files and are chmod'ed, which the umask doesn't apply to
+static mode_t new_file_mode = 0666;
+
 static struct file_lock *find_file_lock(const char *URI) {
     pthread_mutex_lock(&file_locks_mutex);
     for (int i = 0; i < thread_count; i++) {
@@ -67,132 +102,559 @@ static void release_file_lock(struct file_lock *lock) {
     pthread_mutex_unlock(&file_locks_mutex);
 }
 
-static void write_audit_log(const char *op, const char *URI, const int status, const char *req_id) {
+void write_audit_log(const char *op, const char *URI, const int status, const char *req_id) {
     // we can assume fprintf is thread safe
     fprintf(stderr, "%s,/%s,%d,%s\n", op, URI, status, req_id);
 }
 
-Response handle_get(const Request *req) {
+int get_open_error(const int err) {
+    switch (err) {
+    case EACCES:
+    case ENAMETOOLONG:
+    case EPERM:
+    case EROFS: return 403;
+    case ENOENT: return 404;
+    default: return 500;
+    }
+}
 
-    const char *URI = req_get_uri(req);
+int get_stat_error(const int err) {
+    switch (err) {
+    case EACCES:
+    case EBADF:
+    case EFAULT: return 403;
+    case ENOENT: return 404;
+    default: return 500;
+    }
+}
+
+int put_open_error(const int err) {
+    switch (err) {
+    case EISDIR: // is directory
+    case EACCES: // no access
+    case ENAMETOOLONG: // name too long
+    case EPERM: // no permission
+    case EROFS: // readonly file
+        return 403;
+
+    case ENOENT:
+        // file doesn't exist
+        // the caller is going to create it
+        return 0;
+    default: return 500;
+    }
+}
+
+// the format of HTTP dates, e.g. Sun, 06 Nov 1994 08:49:37 GMT
+#define HTTP_DATE_FORMAT "%a, %d %b %Y %H:%M:%S GMT"
+#define HTTP_DATE_MAX    32
+#define ETAG_MAX         80
+
+// the boundary between the parts of multipart/byteranges responses, made once at startup
+static char _boundary[48];
+
+// writes the ETag of a file, quotes included
+// a PUT renames a new file over the old one, so the inode alone already changes with every PUT,
+// size and mtime also catch files changed in place behind our back
+static void make_etag(char *buf, const size_t cap, const struct stat *st) {
+    snprintf(buf, cap, "\"%llx-%llx-%llx.%lx\"", (unsigned long long) st->st_ino,
+        (unsigned long long) st->st_size, (unsigned long long) st->st_mtim.tv_sec,
+        (long) st->st_mtim.tv_nsec);
+}
+
+// whether an If-None-Match list of entity tags matches an ETag, with the weak comparison
+// (a W/ prefix is ignored), as RFC 9110 asks of If-None-Match
+static bool etag_list_matches(const char *list, const char *etag) {
+    const size_t etag_len = strlen(etag);
+
+    while (*list != '\0') {
+        while (*list == ' ' || *list == ',') {
+            list++;
+        }
+        if (*list == '*') {
+            return true;
+        }
+        if (strncmp(list, "W/", 2) == 0) {
+            list += 2;
+        }
+
+        const char *end = list;
+        if (*end == '"') {
+            // an entity tag is a quoted string, without quotes inside
+            end = strchr(end + 1, '"');
+            if (end == NULL) {
+                return false;
+            }
+            end++;
+        } else {
+            // not an entity tag, skip it
+            while (*end != '\0' && *end != ',' && *end != ' ') {
+                end++;
+            }
+        }
+
+        if ((size_t) (end - list) == etag_len && memcmp(list, etag, etag_len) == 0) {
+            return true;
+        }
+        list = end;
+    }
+
+    return false;
+}
+
+bool get_not_modified(const Request *req, const struct stat *st) {
+    // If-None-Match wins when both are there
+    const char *match = req_get_known_header(req, HDR_IF_NONE_MATCH);
+    if (match != NULL) {
+        char etag[ETAG_MAX];
+        make_etag(etag, sizeof(etag), st);
+        return etag_list_matches(match, etag);
+    }
+
+    const char *since = req_get_known_header(req, HDR_IF_MODIFIED_SINCE);
+    if (since != NULL) {
+        struct tm tm;
+        memset(&tm, 0, sizeof(tm));
+        // an invalid date is ignored, as if the header wasn't there
+        return strptime(since, HTTP_DATE_FORMAT, &tm) != NULL && st->st_mtime <= timegm(&tm);
+    }
+
+    return false;
+}
+
+int get_decide(const Request *req, const struct stat *st, RangeSet *ranges) {
+    ranges->count = 0;
+
+    if (get_not_modified(req, st)) {
+        return 304;
+    }
+
+    ByteRange asked[REQ_MAX_RANGES];
+    const int n = req_get_ranges(req, asked, REQ_MAX_RANGES);
+    if (n == 0) {
+        return 200;
+    }
+
+    // keep the satisfiable ranges, with both ends in the file
+    const long long size = st->st_size;
+    for (int i = 0; i < n; i++) {
+        ByteRange r = asked[i];
+        if (r.first == -1) {
+            // the last r.last bytes
+            if (r.last == 0 || size == 0) {
+                continue;
+            }
+            r.first = r.last < size ? size - r.last : 0;
+            r.last = size - 1;
+        } else {
+            if (r.first >= size) {
+                continue;
+            }
+            if (r.last == -1 || r.last >= size) {
+                r.last = size - 1;
+            }
+        }
+        ranges->r[ranges->count++] = r;
+    }
+
+    return ranges->count > 0 ? 206 : 416;
+}
+
+size_t get_part_header(char *buf, const size_t cap, const struct stat *st, const ByteRange *r) {
+    return snprintf(buf, cap,
+        "\r\n--%s\r\nContent-Type: application/octet-stream\r\nContent-Range: bytes %lld-%lld/%lld"
+        "\r\n\r\n",
+        _boundary, r->first, r->last, (long long) st->st_size);
+}
+
+size_t get_parts_end(char *buf, const size_t cap) {
+    return snprintf(buf, cap, "\r\n--%s--\r\n", _boundary);
+}
+
+size_t get_headers(char *buf, const size_t cap, const int status, const struct stat *st,
+    const RangeSet *ranges, const bool closing) {
+    const char *connection = closing ? "Connection: close\r\n" : "";
+
+    if (status == 416) {
+        return snprintf(buf, cap,
+            "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Length: 0\r\n"
+            "Content-Range: bytes */%lld\r\n%s\r\n",
+            (long long) st->st_size, connection);
+    }
+
+    char etag[ETAG_MAX];
+    make_etag(etag, sizeof(etag), st);
+
+    char date[HTTP_DATE_MAX];
+    struct tm tm;
+    gmtime_r(&st->st_mtime, &tm);
+    strftime(date, sizeof(date), HTTP_DATE_FORMAT, &tm);
+
+    if (status == 304) {
+        // no body, and no Content-Length either, it would describe the body we're not sending
+        return snprintf(buf, cap,
+            "HTTP/1.1 304 Not Modified\r\nETag: %s\r\nLast-Modified: %s\r\n%s\r\n", etag, date,
+            connection);
+    }
+
+    if (status == 206 && ranges->count == 1) {
+        const ByteRange *r = &ranges->r[0];
+        return snprintf(buf, cap,
+            "HTTP/1.1 206 Partial Content\r\nContent-Length: %lld\r\n"
+            "Content-Range: bytes %lld-%lld/%lld\r\nETag: %s\r\nLast-Modified: %s\r\n%s\r\n",
+            r->last - r->first + 1, r->first, r->last, (long long) st->st_size, etag, date,
+            connection);
+    }
+
+    if (status == 206) {
+        // every range is a part with its own header, and the parts end with the closing boundary
+        char part[GET_PART_HEADER_MAX];
+        size_t len = get_parts_end(part, sizeof(part));
+        for (int i = 0; i < ranges->count; i++) {
+            const ByteRange *r = &ranges->r[i];
+            len += get_part_header(part, sizeof(part), st, r) + (r->last - r->first + 1);
+        }
+
+        return snprintf(buf, cap,
+            "HTTP/1.1 206 Partial Content\r\nContent-Length: %zu\r\n"
+            "Content-Type: multipart/byteranges; boundary=%s\r\nETag: %s\r\nLast-Modified: %s"
+            "\r\n%s\r\n",
+            len, _boundary, etag, date, connection);
+    }
+
+    return snprintf(buf, cap,
+        "HTTP/1.1 200 OK\r\nContent-Length: %lld\r\nAccept-Ranges: bytes\r\nETag: %s\r\n"
+        "Last-Modified: %s\r\n%s\r\n",
+        (long long) st->st_size, etag, date, connection);
+}
+
+CachedObject *object_from_file(const int fd, const struct stat *st) {
+    if ((size_t) st->st_size > objcache_max_object()) {
+        return NULL;
+    }
+
+    char headers[GET_HEADERS_MAX];
+    const size_t headers_len = get_headers(headers, sizeof(headers), 200, st, NULL, false);
+    return objcache_read(headers, headers_len, fd, st);
+}
+
+// opens a file for GET through the fd cache, returns the status
+static int open_file(const char *URI, CachedFile **file) {
+    // hot files are already open
+    *file = fdcache_get(URI);
+    if (*file != NULL) {
+        return 200;
+    }
 
     // try to open the file
     const int fd = open(URI, O_RDONLY);
     if (fd == -1) {
-        switch (errno) {
-        case EACCES:
-        case ENAMETOOLONG:
-        case EPERM:
-        case EROFS: return RESPONSE_UNSENT(403);
-        case ENOENT: return RESPONSE_UNSENT(404);
-        default: return RESPONSE_UNSENT(500);
-        }
+        return get_open_error(errno);
     }
 
     // check if the URI is a directory using fstat
     struct stat st;
-    const int st_res = fstat(fd, &st);
-    if (st_res == -1) {
-        switch (errno) {
-        case EACCES:
-        case EBADF:
-        case EFAULT: close(fd); return RESPONSE_UNSENT(403);
-        case ENOENT: close(fd); return RESPONSE_UNSENT(404);
-        default: close(fd); return RESPONSE_UNSENT(500);
-        }
+    if (fstat(fd, &st) == -1) {
+        const int err = errno;
+        close(fd);
+        return get_stat_error(err);
     }
 
     if (S_ISDIR(st.st_mode)) {
         close(fd);
-        return RESPONSE_UNSENT(403);
+        return 403;
+    }
+
+    *file = fdcache_insert(URI, fd, &st);
+    if (*file == NULL) {
+        close(fd);
+        return 500;
     }
 
-    // get the file size
-    const off_t file_size = st.st_size;
+    return 200;
+}
+
+int get_open(const char *URI, CachedObject **obj, CachedFile **file) {
+    *file = NULL;
+
+    // hot small files are answered from memory
+    *obj = objcache_get(URI);
+    if (*obj != NULL) {
+        return 200;
+    }
+
+    const int status = open_file(URI, file);
+    if (status != 200) {
+        return status;
+    }
+
+    // keep small files in memory for the next GETs, the reader lock keeps PUTs out meanwhile
+    *obj = object_from_file((*file)->fd, &(*file)->st);
+    if (*obj != NULL) {
+        objcache_insert(URI, *obj);
+        fdcache_release(*file);
+        *file = NULL;
+    }
+
+    return 200;
+}
+
+// the responses of pipelined requests, collected so they go out together (see next_request)
+// a worker serves one connection at a time, so it needs one batch
+static __thread IoBatch _batch;
+// the cached objects _batch points into, released once it is flushed
+static __thread CachedObject *_batch_objs[IO_BATCH_MAX];
+static __thread int _batch_num_objs;
+
+static void batch_flush(const int sock, const int flags) {
+    io_batch_flush(sock, &_batch, flags);
+
+    for (int i = 0; i < _batch_num_objs; i++) {
+        objcache_release(_batch_objs[i]);
+    }
+    _batch_num_objs = 0;
+}
+
+// adds data that stays valid until the batch is flushed
+static void batch_add(const int sock, const void *buf, const size_t n) {
+    if (!io_batch_add(&_batch, buf, n)) {
+        batch_flush(sock, MSG_MORE);
+        io_batch_add(&_batch, buf, n);
+    }
+}
+
+// adds a copy of at most IO_BATCH_COPY bytes
+static void batch_copy(const int sock, const void *buf, const size_t n) {
+    if (!io_batch_copy(&_batch, buf, n)) {
+        batch_flush(sock, MSG_MORE);
+        io_batch_copy(&_batch, buf, n);
+    }
+}
+
+// adds a complete cached response, taking over the reference to it
+static void batch_object(const int sock, CachedObject *obj) {
+    batch_add(sock, obj->data, obj->len);
+    _batch_objs[_batch_num_objs++] = obj;
+}
+
+// sends n bytes of the body of a GET, starting at off, from whichever of obj and file is set
+// more is true if more of the response follows
+static void send_body(const int sock, const CachedObject *obj, const CachedFile *file,
+    const off_t off, const size_t n, const bool more) {
+    if (obj != NULL) {
+        const char *body = obj->data + obj->len - obj->st.st_size;
+        io_send_all(sock, body + off, n, more ? MSG_MORE : 0);
+        return;
+    }
+
+    // send the file directly to the client, without copying it through userspace
+    // other GETs may be sending the same fd, which is fine as long as nothing uses its offset
+    if (mmap_threshold >= 0 && file->st.st_size >= mmap_threshold) {
+        io_send_mapped(sock, file->fd, off, n);
+    } else {
+        io_send_file(sock, file->fd, off, n);
+    }
+}
+
+Response handle_get(const Request *req, const int status, CachedObject *obj, CachedFile *file,
+    const RangeSet *ranges) {
     const int sock = req_get_sockfd(req);
+    const struct stat *st = obj != NULL ? &obj->st : &file->st;
 
-    write_n_bytes(sock, "HTTP/1.1 200 OK\r\n", 17);
-    // write file size
-    char file_size_str[64];
-    sprintf(file_size_str, "Content-Length: %lu\r\n", file_size);
-    write_n_bytes(sock, file_size_str, strlen(file_size_str));
-    write_n_bytes(sock, "\r\n", 2);
+    if (status == 200 && obj != NULL) {
+        // the whole response is ready, it joins the batch as is
+        batch_object(sock, obj);
+        return RESPONSE_SENT(status);
+    }
 
-    // send the file directly to the client
-    pass_n_bytes(fd, sock, file_size);
+    char headers[GET_HEADERS_MAX];
+    const size_t headers_len = get_headers(headers, sizeof(headers), status, st, ranges, false);
+    batch_copy(sock, headers, headers_len);
+
+    const bool has_body = (status == 200 && st->st_size > 0) || status == 206;
+    if (has_body) {
+        // MSG_MORE holds the headers back, so they go out in the same segment as the start of the
+        // body
+        batch_flush(sock, MSG_MORE);
+
+        if (status == 200) {
+            send_body(sock, obj, file, 0, st->st_size, false);
+        } else if (status == 206 && ranges->count == 1) {
+            const ByteRange *r = &ranges->r[0];
+            send_body(sock, obj, file, r->first, r->last - r->first + 1, false);
+        } else if (status == 206) {
+            // multipart/byteranges, each range with a part header in front
+            char part[GET_PART_HEADER_MAX];
+            for (int i = 0; i < ranges->count; i++) {
+                const ByteRange *r = &ranges->r[i];
+                io_send_all(sock, part, get_part_header(part, sizeof(part), st, r), MSG_MORE);
+                send_body(sock, obj, file, r->first, r->last - r->first + 1, true);
+            }
+            io_send_all(sock, part, get_parts_end(part, sizeof(part)), 0);
+        }
+    }
 
-    // close the file
-    close(fd);
+    if (obj != NULL) {
+        objcache_release(obj);
+    } else {
+        fdcache_release(file);
+    }
 
-    return RESPONSE_SENT(200);
+    return RESPONSE_SENT(status);
 }
 
-Response handle_put(Request *req) {
-    // get the content length from the headers
-    const ssize_t content_length = req_get_content_length(req);
+int put_create_temp(char *path) {
+    memcpy(path, PUT_TEMP_TEMPLATE, sizeof(PUT_TEMP_TEMPLATE));
+    return mkstemp(path);
+}
 
-    // if the content length is invalid, return 400
-    if (content_length < 0) {
-        return RESPONSE_UNSENT(400);
+int put_check(const char *URI) {
+    struct stat st;
+    if (stat(URI, &st) == -1) {
+        // most likely doesn't exist yet, put_publish finds out for sure
+        return 0;
     }
 
-    const char *URI = req_get_uri(req);
-    const bufsize_t body_size = req_get_body_size(req);
+    if (S_ISDIR(st.st_mode)) {
+        return 403;
+    }
+    return access(URI, W_OK) == -1 && put_open_error(errno) == 403 ? 403 : 0;
+}
 
-    int fd = open(URI, O_WRONLY | O_TRUNC, 0);
-    int res;
+int put_publish(const char *tmp_path, const char *URI, CachedObject *obj) {
+    // opening the URI checks everything writing to it in place used to
+    int status;
+    mode_t mode;
+    const int fd = open(URI, O_WRONLY);
     if (fd == -1) {
-        switch (errno) {
-        case EISDIR: // is directory
-        case EACCES: // no access
-        case ENAMETOOLONG: // name too long
-        case EPERM: // no permission
-        case EROFS: // readonly file
-            return RESPONSE_UNSENT(403);
-
-        case ENOENT:
-            // file doesn't exist
-            // we are going to create it (below)
-            break;
-        default: return RESPONSE_UNSENT(500);
+        status = put_open_error(errno);
+        if (status != 0) {
+            unlink(tmp_path);
+            return status;
         }
 
-        fd = creat(URI, 0666);
+        // file doesn't exist, it's created by the rename
+        status = 201;
+        mode = new_file_mode;
+    } else {
+        // replacing the file keeps its permissions
+        struct stat st;
+        status = 200;
+        mode = fstat(fd, &st) == 0 ? st.st_mode & 07777 : new_file_mode;
+        close(fd);
+    }
+
+    if (chmod(tmp_path, mode) == -1 || rename(tmp_path, URI) == -1) {
+        unlink(tmp_path);
+        return 500;
+    }
 
-        res = 201;
+    // GETs from now on must see the new file
+    fdcache_invalidate(URI);
+    if (obj != NULL) {
+        objcache_insert(URI, obj);
     } else {
-        res = 200;
+        objcache_invalidate(URI);
     }
 
-    if (content_length == 0) {
-        // no content to write, we're just done here
-        close(fd);
-        return RESPONSE_UNSENT(res);
+    return status;
+}
+
+/**
+ * @brief Receives the body of a PUT into a new temporary file, without holding any lock
+ *
+ * @param req The PUT request
+ * @param tmp_path Set to the path of the temporary file, PUT_TEMP_SIZE bytes
+ * @param obj Set to the new object to write through to the object cache, or NULL if the file is
+ * too large for it
+ * @return 0 once the whole body is in the file, ready for put_publish, otherwise the status to
+ * respond with (and there is no file)
+*/
+static int put_receive(Request *req, char *tmp_path, CachedObject **obj) {
+    *obj = NULL;
+
+    // get the content length from the headers
+    const ssize_t content_length = req_get_content_length(req);
+
+    // if the content length is invalid, return 400
+    if (content_length < 0) {
+        return 400;
     }
 
+    // don't take a body only to throw it away
+    const int refused = put_check(req_get_uri(req));
+    if (refused != 0) {
+        return refused;
+    }
+
+    const int fd = put_create_temp(tmp_path);
+    if (fd == -1) {
+        return 500;
+    }
+
+    // we know how large the file is going to be, reserve the space up front
+    io_preallocate(fd, content_length);
+
+    // bulk uploads shouldn't push the files being read out of the page cache
+    const bool drop_cache = drop_cache_threshold >= 0 && content_length >= drop_cache_threshold;
+    // and on slow disks they go faster receiving and writing at the same time
+    const bool pipeline = pipeline_threshold >= 0 && content_length >= pipeline_threshold;
+
     ssize_t total_wb = 0;
-    ssize_t wb;
+    const bufsize_t body_size = req_get_body_size(req);
 
-    if (body_size > 0) {
+    if (body_size > 0 && content_length > 0) {
         // write the body that's already in the buffer
-        char *body = req_get_body(req);
-        wb = write_n_bytes(fd, body, body_size);
-        total_wb += wb;
+        const size_t n = body_size < content_length ? (size_t) body_size : (size_t) content_length;
+        // a short write would leave a hole, it counts as failed
+        total_wb = write_n_bytes(fd, req_get_body(req), n) == (ssize_t) n ? (ssize_t) n : -1;
     }
 
-    if (total_wb == content_length) {
-        // we're done
-        close(fd);
-        return RESPONSE_UNSENT(res);
+    if (total_wb >= 0 && total_wb < content_length) {
+        // the client may wait for the responses so far before sending the rest
+        const int sock = req_get_sockfd(req);
+        batch_flush(sock, 0);
+
+        // move the rest of the body from the socket to the file, without copying it through
+        // userspace (or overlapping the two sides, for pipelined PUTs)
+        const int flags = (drop_cache ? IO_DROP_CACHE : 0) | (pipeline ? IO_PIPELINE : 0);
+
+        struct timespec start, end;
+        const bool stats = pipeline && pipeline_stats;
+        if (stats) {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+        }
+        const ssize_t rb = io_recv_file(sock, fd, content_length - total_wb, flags);
+
+        if (stats) {
+            // stdout is free, the audit log is on stderr
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            const double secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+            printf("PUT /%s: %zd bytes in %.3f s, %.1f MB/s\n", req_get_uri(req), rb, secs,
+                rb > 0 && secs > 0 ? rb / secs / 1e6 : 0.0);
+            fflush(stdout);
+        }
+        total_wb = rb < 0 ? -1 : total_wb + rb;
     }
 
-    // pass the rest of the body to the file
-    const int sock = req_get_sockfd(req);
-    pass_n_bytes(sock, fd, content_length - total_wb);
+    // small files go straight into the object cache once published
+    struct stat st;
+    *obj = total_wb == content_length && fstat(fd, &st) == 0 ? object_from_file(fd, &st) : NULL;
+
+    if (drop_cache) {
+        io_drop_cache(fd);
+    }
 
     close(fd);
 
-    return RESPONSE_UNSENT(res);
+    if (total_wb != content_length) {
+        // don't replace the file with part of the body: a write that failed is our error, the
+        // client stopping short of its content length is the client's
+        unlink(tmp_path);
+        return total_wb < 0 ? 500 : 400;
+    }
+
+    return 0;
 }
 
 Response handle_connection(Request *req) {
@@ -200,107 +662,181 @@ Response handle_connection(Request *req) {
         return RESPONSE_UNSENT(400);
     }
 
-    const char *request_id = req_get_header_value(req, "Request-Id");
+    const char *request_id = req_get_known_header(req, HDR_REQUEST_ID);
     if (request_id == NULL) {
         return RESPONSE_UNSENT(400);
     }
 
-    Response response;
     struct file_lock *lock;
     const char *URI = req_get_uri(req);
+    int status;
+    CachedObject *obj;
+    CachedFile *file;
+    RangeSet ranges;
+    char tmp_path[PUT_TEMP_SIZE];
 
     switch (req_get_method(req)) {
     case GET:
+        // a PUT replaces the file with a rename, so once it's open we keep reading the version we
+        // opened, only the open has to be ordered against PUTs
         lock = find_file_lock(URI);
         reader_lock(lock->lock);
-        response = handle_get(req);
-        write_audit_log("GET", URI, response.status, request_id);
+        status = get_open(URI, &obj, &file);
+        if (status == 200) {
+            // conditional and range requests only get part of it
+            status = get_decide(req, obj != NULL ? &obj->st : &file->st, &ranges);
+        }
+        write_audit_log("GET", URI, status, request_id);
         reader_unlock(lock->lock);
         release_file_lock(lock);
 
-        break;
+        if (obj == NULL && file == NULL) {
+            return RESPONSE_UNSENT(status);
+        }
+        return handle_get(req, status, obj, file, &ranges);
     case PUT:
+        // the body goes to a temporary file first, only replacing the file needs the lock
+        status = put_receive(req, tmp_path, &obj);
+        if (status != 0) {
+            write_audit_log("PUT", URI, status, request_id);
+            return RESPONSE_UNSENT(status);
+        }
+
         lock = find_file_lock(URI);
         writer_lock(lock->lock);
-        response = handle_put(req);
-        write_audit_log("PUT", URI, response.status, request_id);
+        status = put_publish(tmp_path, URI, obj);
+        write_audit_log("PUT", URI, status, request_id);
         writer_unlock(lock->lock);
         release_file_lock(lock);
 
-        break;
+        if (obj != NULL) {
+            objcache_release(obj);
+        }
+
+        return RESPONSE_UNSENT(status);
     default: return RESPONSE_UNSENT(501);
     }
-
-    return response;
 }
 
-/**
- * Responds with pre-written responses based on the status code.
- * Any errors during writing are ignored.
-*/
-void respond(const int conn, const int status) {
-    char *status_line, *body;
-
+static void response_text(const int status, const char **status_line, const char **body) {
     switch (status) {
     case 200:
-        status_line = "200 OK";
-        body = "OK\n";
+        *status_line = "200 OK";
+        *body = "OK\n";
         break;
     case 201:
-        status_line = "201 Created";
-        body = "Created\n";
+        *status_line = "201 Created";
+        *body = "Created\n";
+        break;
+    case 304:
+        *status_line = "304 Not Modified";
+        *body = "";
         break;
     case 400:
-        status_line = "400 Bad Request";
-        body = "Bad Request\n";
+        *status_line = "400 Bad Request";
+        *body = "Bad Request\n";
         break;
     case 403:
-        status_line = "403 Forbidden";
-        body = "Forbidden\n";
+        *status_line = "403 Forbidden";
+        *body = "Forbidden\n";
         break;
     case 404:
-        status_line = "404 Not Found";
-        body = "Not Found\n";
+        *status_line = "404 Not Found";
+        *body = "Not Found\n";
         break;
     case 501:
-        status_line = "501 Not Implemented";
-        body = "Not Implemented\n";
+        *status_line = "501 Not Implemented";
+        *body = "Not Implemented\n";
         break;
     case 505:
-        status_line = "505 Version Not Supported";
-        body = "Version Not Supported\n";
+        *status_line = "505 Version Not Supported";
+        *body = "Version Not Supported\n";
         break;
     case 500:
     default:
         // also return 500 if we somehow try to return an invalid status code
-        status_line = "500 Internal Server Error";
-        body = "Internal Server Error\n";
+        *status_line = "500 Internal Server Error";
+        *body = "Internal Server Error\n";
     }
+}
 
-    /*
-    HTTP/1.1 <status_line>\r\n
-    Content-Length: <length>\r\n
-    \r\n
-    <body>
-    */
+// every status code respond() supports
+static const int _statuses[] = {200, 201, 304, 400, 403, 404, 500, 501, 505};
 
-    // write status line
-    write_n_bytes(conn, "HTTP/1.1 ", 9);
-    write_n_bytes(conn, status_line, strlen(status_line));
+#define NUM_STATUSES (sizeof(_statuses) / sizeof(_statuses[0]))
+#define CANNED_MAX 128
 
-    write_n_bytes(conn, "\r\n", 2);
+// the complete serialized response of each status in _statuses, see responses_init
+// the second of each says the connection closes after it
+static char _canned[NUM_STATUSES][2][CANNED_MAX];
+static size_t _canned_len[NUM_STATUSES][2];
 
-    // now write headers
-    // content length (for curl to work properly)
-    write_n_bytes(conn, "Content-Length: ", 16);
-    char content_len[130];
-    sprintf(content_len, "%lu\r\n", strlen(body));
-    write_n_bytes(conn, content_len, strlen(content_len));
+// whether a connection can go on to its next request after a response with this status
+static bool status_keeps_connection(const int status) {
+    // these may leave (part of) a body unread, or come from a request that can't be trusted to
+    // end where it says
+    return status != 400 && status != 500 && status != 501 && status != 505;
+}
 
-    write_n_bytes(conn, "\r\n", 2);
+void responses_init(void) {
+    // a part boundary must not show up in the files sent, a random one makes that unlikely
+    unsigned long long r[2];
+    if (getrandom(r, sizeof(r), 0) != sizeof(r)) {
+        r[0] = time(NULL);
+        r[1] = getpid();
+    }
+    snprintf(_boundary, sizeof(_boundary), "byteranges-%016llx%016llx", r[0], r[1]);
+
+    for (size_t i = 0; i < NUM_STATUSES; i++) {
+        const char *status_line, *body;
+        response_text(_statuses[i], &status_line, &body);
+
+        for (int closing = 0; closing <= 1; closing++) {
+            const char *connection
+                = closing || !status_keeps_connection(_statuses[i]) ? "Connection: close\r\n" : "";
+
+            if (_statuses[i] == 304) {
+                // a 304 never has a body, nor a Content-Length
+                _canned_len[i][closing] = snprintf(_canned[i][closing], CANNED_MAX,
+                    "HTTP/1.1 %s\r\n%s\r\n", status_line, connection);
+                continue;
+            }
+
+            /*
+            HTTP/1.1 <status_line>\r\n
+            Content-Length: <length>\r\n
+            [Connection: close\r\n]
+            \r\n
+            <body>
+            */
+            _canned_len[i][closing] = snprintf(_canned[i][closing], CANNED_MAX,
+                "HTTP/1.1 %s\r\nContent-Length: %zu\r\n%s\r\n%s", status_line, strlen(body),
+                connection, body);
+        }
+    }
+}
 
-    // now write body
-    write_n_bytes(conn, body, strlen(body));
+const char *canned_response(const int status, const bool closing, size_t *len) {
+    for (size_t i = 0; i < NUM_STATUSES; i++) {
+        if (_statuses[i] == status) {
+            *len = _canned_len[i][closing];
+            return _canned[i][closing];
+        }
+    }
+
+    // also return 500 if we somehow try to return an invalid status code
+    return canned_response(500, closing, len);
+}
+
+/**
+ * Responds with pre-written responses based on the status code.
+ * The response joins the batch of the connection, to be sent with the responses around it.
+ * Any errors during writing are ignored.
+*/
+void respond(const int conn, const int status) {
+    size_t len;
+    const char *response = canned_response(status, false, &len);
+    batch_add(conn, response, len);
 }
 
 static void signal_handler(const int n) {
@@ -317,26 +853,101 @@ static void signal_handler(const int n) {
     running = false;
 }
 
-static void parse_command(const int argc, char *const *argv, int *port, int *threads) {
-    switch (getopt(argc, argv, "t:")) {
-    case 't':
-        if (sscanf(optarg, "%d", threads) != 1) {
-            fprintf(stderr, "Invalid thread count: %s\n", optarg);
-            exit(1);
+#define USAGE                                                                                      \
+    "Usage: %s [-t threads] [-b max_header_bytes] [-e threads|uring] [-m mmap_min_bytes] "         \
+    "[-d drop_cache_min_bytes] [-p pipeline_min_bytes [-s]] [-f fd_cache_files] "                  \
+    "[-o object_cache_bytes] [-k keep_alive_secs] [-r [-c]] <port>\n"                              \
+    "  -s prints the MB/s of every pipelined PUT to stdout\n"
+
+static void parse_command(const int argc, char *const *argv, int *port, int *threads, bool *uring) {
+    int opt, max_size;
+
+    // default to 4 threads, with the thread pool engine
+    *threads = 4;
+    *uring = false;
+
+    while ((opt = getopt(argc, argv, "t:b:e:m:d:p:sf:o:k:rc")) != -1) {
+        switch (opt) {
+        case 't':
+            if (sscanf(optarg, "%d", threads) != 1) {
+                fprintf(stderr, "Invalid thread count: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'b':
+            // limit on the request line and headers, for clients sending many headers
+            // a single header is still at most 128 bytes of key and of value (seb_http_grammar.h)
+            if (sscanf(optarg, "%d", &max_size) != 1 || req_set_max_size(max_size) != 0) {
+                fprintf(stderr, "Invalid header buffer size: %s (must be %d to %d)\n", optarg,
+                    REQ_MAX_SIZE, REQ_MAX_SIZE_LIMIT);
+                exit(1);
+            }
+            break;
+        case 'e':
+            // which engine serves connections
+            if (strcmp(optarg, "uring") == 0) {
+                *uring = true;
+            } else if (strcmp(optarg, "threads") == 0) {
+                *uring = false;
+            } else {
+                fprintf(stderr, "Invalid engine: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'm':
+            // GET files of at least this many bytes from a memory mapping
+            if (sscanf(optarg, "%lld", &mmap_threshold) != 1 || mmap_threshold < 0) {
+                fprintf(stderr, "Invalid mmap threshold: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'd':
+            // keep PUTs of at least this many bytes out of the page cache
+            if (sscanf(optarg, "%lld", &drop_cache_threshold) != 1 || drop_cache_threshold < 0) {
+                fprintf(stderr, "Invalid drop cache threshold: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'p':
+            // copy PUTs of at least this many bytes with the pipelined engine
+            if (sscanf(optarg, "%lld", &pipeline_threshold) != 1 || pipeline_threshold < 0) {
+                fprintf(stderr, "Invalid pipeline threshold: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'f':
+            // keep up to this many files open for GET, each is a file descriptor
+            if (sscanf(optarg, "%d", &fd_cache_size) != 1 || fd_cache_size < 0) {
+                fprintf(stderr, "Invalid fd cache size: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'o':
+            // keep small files in up to this much memory, as ready to send responses
+            if (sscanf(optarg, "%lld", &object_cache_bytes) != 1 || object_cache_bytes < 0) {
+                fprintf(stderr, "Invalid object cache size: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'k':
+            // serve more requests on a connection, until it is idle this long
+            if (sscanf(optarg, "%d", &keep_alive_secs) != 1 || keep_alive_secs < 0) {
+                fprintf(stderr, "Invalid keep-alive timeout: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'r':
+            // no acceptor thread or queue, for connection rates one thread can't accept
+            reuseport = true;
+            break;
+        case 'c': incoming_cpu = true; break;
+        case 's': pipeline_stats = true; break;
+        default: fprintf(stderr, USAGE, argv[0]); exit(1);
         }
-        break;
-    case '?':
-        fprintf(stderr, "Usage: %s [-t threads] <port>\n", optarg);
-        exit(1);
-        break;
-    default:
-        // default to 4 threads
-        *threads = 4;
-        break;
     }
 
     if (optind >= argc) {
-        fprintf(stderr, "Usage: %s [-t threads] <port>\n", argv[0]);
+        fprintf(stderr, USAGE, argv[0]);
         exit(1);
     }
 
@@ -346,28 +957,87 @@ static void parse_command(const int argc, char *const *argv, int *port, int *thr
     }
 }
 
-void *worker_thread(void *arg) {
-    queue_t *queue = arg;
-    Request *req;
+// what happens to a connection after a response
+typedef enum {
+    // its next request is already buffered, serve it right away
+    CONN_NEXT,
+    // give it back to the reactor, to wait for its next request
+    CONN_WAIT,
+    // close it
+    CONN_CLOSE,
+} ConnNext;
+
+// gets a connection ready for its next request, once the last response is out
+static ConnNext next_request(Request *req, const int status) {
+    if (keep_alive_secs == 0 || !status_keeps_connection(status) || !req_keep_alive(req)) {
+        return CONN_CLOSE;
+    }
 
-    while (true) {
-        queue_pop(queue, (void **) &req);
-        Response response = handle_connection(req);
+    // a GET body is never read, the connection can only go on if it was all in the buffer
+    const ssize_t content_length = req_get_content_length(req);
+    const size_t body_len = content_length > 0 ? content_length : 0;
+    if (req_get_method(req) == GET && body_len > (size_t) req_get_body_size(req)) {
+        return CONN_CLOSE;
+    }
+
+    req_next(req, body_len);
+    if (req_has_data(req) && req_parse_commit(req, 0) != PARSE_AGAIN) {
+        // the client pipelined the next request, its response joins the batch of this one
+        return CONN_NEXT;
+    }
+
+    // the rest of the next request may take a while, the reactor waits for it instead of us
+    return CONN_WAIT;
+}
+
+// serves the requests of a connection until it has to wait for the next one, or is done
+static void serve_connection(ReactorConn *conn) {
+    Request *req = conn->req;
+
+    Response response;
+    ConnNext next;
+    do {
+        response = handle_connection(req);
 
         if (!response.responded) {
             respond(req_get_sockfd(req), response.status);
         }
+    } while ((next = next_request(req, response.status)) == CONN_NEXT);
 
-        req_close(req);
-        req_free(req);
+    // the client may be waiting for these before it sends anything more
+    batch_flush(req_get_sockfd(req), 0);
+
+    if (next == CONN_WAIT) {
+        reactor_return(conn);
+    } else {
+        reactor_close(conn);
+    }
+}
+
+void *worker_thread(void *arg) {
+    queue_t *queue = arg;
+    ReactorConn *conn;
+
+    // one at a time, even when the reactor pushed several: a worker holding more would keep
+    // complete requests waiting behind a slow transfer while other workers sit idle
+    while (true) {
+        queue_pop(queue, (void **) &conn);
+        serve_connection(conn);
     }
 
     return NULL;
 }
 
+// runs a reactor of its own, serving its connections on this thread (-r)
+static void *acceptor_thread(void *arg) {
+    reactor_run(arg, &running);
+    return NULL;
+}
+
 int main(const int argc, char *const argv[]) {
     int port, threads;
-    parse_command(argc, argv, &port, &threads);
+    bool uring;
+    parse_command(argc, argv, &port, &threads, &uring);
 
     // make sure the port is in the valid range
     if (port < 1 || port > 65535) {
@@ -375,9 +1045,22 @@ int main(const int argc, char *const argv[]) {
         return 1;
     }
 
-    sock.fd = 0;
+    // with -r, every worker listens on the port itself, opened here so a bad port is caught early
+    // workers are spread over the CPUs, with -c each one takes what the kernel received on its own
+    const bool per_worker = reuseport && !uring;
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int listeners[threads];
+
+    for (int i = 0; per_worker && i < threads; i++) {
+        if ((listeners[i] = reactor_listen(port, incoming_cpu ? i % cpus : -1)) == -1) {
+            fprintf(stderr, "Invalid port: %d\n", port);
+            return 1;
+        }
+    }
+
+    sock.fd = -1;
     // try to listen on the port, if it fails print Invalid port: <port>
-    if (listener_init(&sock, port) == -1) {
+    if (!per_worker && listener_init(&sock, port) == -1) {
         fprintf(stderr, "Invalid port: %d\n", port);
         return 1;
     }
@@ -386,12 +1069,19 @@ int main(const int argc, char *const argv[]) {
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
-    if (seb_http_regex_init() != 0) {
-        fprintf(stderr, "Failed to initialize regex\n");
-        return 1;
+    responses_init();
+    fdcache_init(fd_cache_size);
+    objcache_init(object_cache_bytes);
+
+    const mode_t mask = umask(0);
+    umask(mask);
+    new_file_mode = 0666 & ~mask;
+
+    if (uring) {
+        // the io_uring engine runs its own threads and keeps its own URI locks
+        return uring_engine_run(sock.fd, threads, &running) == 0 ? 0 : 1;
     }
 
-    queue_t *queue = queue_new(threads);
     // lol
     pthread_t _real_threads_array_but_its_on_the_stack[threads];
     threads_arr = _real_threads_array_but_its_on_the_stack;
@@ -400,19 +1090,51 @@ int main(const int argc, char *const argv[]) {
     struct file_lock _real_file_locks_array_but_its_on_the_stack[threads];
     file_locks = _real_file_locks_array_but_its_on_the_stack;
 
+    // every worker may look at every lock, they all have to be there before the first one starts
     for (int i = 0; i < threads; i++) {
-        pthread_create(&threads_arr[i], NULL, worker_thread, queue);
         file_locks[i].lock = rwlock_new(N_WAY, 1);
         file_locks[i].filename = NULL;
         file_locks[i].users = 0;
     }
 
-    int conn;
-    while (running) {
-        if ((conn = listener_accept(&sock)) != -1) {
-            Request *req = req_create(conn);
-            queue_push(queue, req);
+    // without keep-alive, a connection still only gets so long to send its request
+    const int idle_secs = keep_alive_secs > 0 ? keep_alive_secs : REQUEST_TIMEOUT;
+    queue_t *queue = NULL;
+
+    if (per_worker) {
+        // no queue, every worker reads and serves the requests of the connections it accepted
+        for (int i = 0; i < threads; i++) {
+            Reactor *reactor = reactor_new(listeners[i], NULL, serve_connection, idle_secs);
+            if (reactor == NULL) {
+                perror("reactor_new");
+                return 1;
+            }
+
+            pthread_attr_t attr;
+            pthread_attr_init(&attr);
+            if (incoming_cpu) {
+                // stay on the CPU the listener takes connections from
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(i % cpus, &set);
+                pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+            }
+            pthread_create(&threads_arr[i], &attr, acceptor_thread, reactor);
+            pthread_attr_destroy(&attr);
+        }
+    } else {
+        queue = queue_new(threads);
+        for (int i = 0; i < threads; i++) {
+            pthread_create(&threads_arr[i], NULL, worker_thread, queue);
         }
+
+        // this thread reads requests off the connections, the workers only get complete ones
+        Reactor *reactor = reactor_new(sock.fd, queue, NULL, idle_secs);
+        if (reactor == NULL) {
+            perror("reactor_new");
+            return 1;
+        }
+        reactor_run(reactor, &running);
     }
 
     for (int i = 0; i < threads; i++) {
@@ -420,8 +1142,9 @@ int main(const int argc, char *const argv[]) {
         rwlock_delete(&file_locks[i].lock);
     }
 
-    queue_delete(&queue);
-    seb_http_regex_cleanup();
+    if (queue != NULL) {
+        queue_delete(&queue);
+    }
 
     return 0;
 }
@@ -0,0 +1,189 @@
+/**
+ * @file httpserver.h
+ *
+ * What the request handlers of httpserver.c share with the other server engines,
+ * so every engine responds and logs the same way
+ *
+ * @author Sebastian Law
+*/
+
+#pragma once
+
+#include "seb_fdcache.h"
+#include "seb_http.h"
+#include "seb_objcache.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// how long a connection may take to send its request without keep-alive, in seconds
+// also how long a read of its body may wait (the receive timeout the reactor sets, and the linked
+// timeout of every receive of the io_uring engine)
+#define REQUEST_TIMEOUT 5
+
+/**
+ * @brief Writes a line of the audit log for a handled request
+*/
+void write_audit_log(const char *op, const char *URI, const int status, const char *req_id);
+
+/**
+ * @brief Serializes the pre-written response of every status code, call once at startup
+*/
+void responses_init(void);
+
+/**
+ * @brief Returns the complete pre-written response for a status code, ready to be sent as is
+ *
+ * Unknown status codes get the 500 response.
+ *
+ * @param status The status code
+ * @param closing Whether the response says the connection closes after it (Connection: close),
+ * responses to requests that can't be trusted (400, 500, 501, 505) always do
+ * @param len Set to the length of the response
+*/
+const char *canned_response(const int status, const bool closing, size_t *len);
+
+/**
+ * @brief Returns the status to respond with when opening a file for GET fails with err
+*/
+int get_open_error(const int err);
+
+/**
+ * @brief Returns the status to respond with when stat'ing an opened file for GET fails with err
+*/
+int get_stat_error(const int err);
+
+/**
+ * @brief Returns the status to respond with when opening a file for PUT fails with err
+ *
+ * Returns 0 for ENOENT, in which case the file should be created instead.
+*/
+int put_open_error(const int err);
+
+// room for the headers of a response to a GET of a file
+#define GET_HEADERS_MAX 320
+// room for the header of a part of a multipart/byteranges response, and for the closing boundary
+#define GET_PART_HEADER_MAX 192
+
+/**
+ * @struct RangeSet
+ * @brief The ranges a 206 response sends, both ends of each within the file
+*/
+typedef struct {
+    int count;
+    ByteRange r[REQ_MAX_RANGES];
+} RangeSet;
+
+/**
+ * @brief Decides how to answer a GET of a file that was found: 200, 206, 304 or 416
+ *
+ * A conditional GET that matches (see get_not_modified) gets a 304. Otherwise a Range header gets
+ * a 206 with its satisfiable ranges, or a 416 if none is.
+ *
+ * @param req The request
+ * @param st The stat of the file
+ * @param ranges Set to the ranges to send for a 206
+ * @return The status
+*/
+int get_decide(const Request *req, const struct stat *st, RangeSet *ranges);
+
+/**
+ * @brief Writes the status line and headers of a response to a GET of a file
+ *
+ * The validators of the file (ETag, from its inode, size and mtime, and Last-Modified) are
+ * included, except in a 416. A 200 or 206 also has the Content-Length of the body that follows.
+ * A 206 of several ranges is multipart/byteranges: its body is get_part_header and the range for
+ * each range, then get_parts_end.
+ *
+ * @param buf Where to write the headers, GET_HEADERS_MAX bytes is always enough
+ * @param cap The size of buf
+ * @param status 200, 206, 304 or 416
+ * @param st The stat of the file
+ * @param ranges The ranges of a 206, NULL otherwise
+ * @param closing Whether to say the connection closes after the response (Connection: close)
+ * @return The length of the headers
+*/
+size_t get_headers(char *buf, const size_t cap, const int status, const struct stat *st,
+    const RangeSet *ranges, const bool closing);
+
+/**
+ * @brief Writes the header of one part of a multipart/byteranges body, returns its length
+*/
+size_t get_part_header(char *buf, const size_t cap, const struct stat *st, const ByteRange *r);
+
+/**
+ * @brief Writes the closing boundary of a multipart/byteranges body, returns its length
+*/
+size_t get_parts_end(char *buf, const size_t cap);
+
+/**
+ * @brief Returns whether a GET is conditional, and the file matches its condition so the
+ * response is a 304
+ *
+ * If-None-Match is checked against the ETag of the file (weak comparison), or if there is none,
+ * If-Modified-Since against its mtime. An If-Modified-Since that isn't a valid HTTP date is
+ * ignored.
+*/
+bool get_not_modified(const Request *req, const struct stat *st);
+
+/**
+ * @brief Builds the complete response to a GET of a file, if it is small enough for the object
+ * cache, returns NULL otherwise
+ *
+ * The object isn't cached yet, see objcache_insert.
+*/
+CachedObject *object_from_file(const int fd, const struct stat *st);
+
+/**
+ * @brief Opens a file for GET (or finds it in a cache), returns the status to respond with
+ *
+ * When the status is 200, exactly one of obj and file is set: obj if the file is small enough
+ * to be answered from the object cache, file otherwise. Give them back with objcache_release
+ * and fdcache_release.
+ *
+ * @param URI The file to open
+ * @param obj Set to a reference to the complete response
+ * @param file Set to a reference to the open file
+*/
+int get_open(const char *URI, CachedObject **obj, CachedFile **file);
+
+// the temporary files PUT bodies are received into, in the served directory so they can be
+// renamed over the URI. URIs can't contain '_', so these are never served or overwritten.
+#define PUT_TEMP_TEMPLATE ".put_XXXXXX"
+#define PUT_TEMP_SIZE     sizeof(PUT_TEMP_TEMPLATE)
+
+/**
+ * @brief Creates a new temporary file to receive a PUT body into
+ *
+ * @param path Set to the path of the file, PUT_TEMP_SIZE bytes
+ * @return The file opened for writing, or -1 with errno set
+*/
+int put_create_temp(char *path);
+
+/**
+ * @brief Checks whether a PUT to URI is going to be refused, before receiving its body
+ *
+ * Only a cheap early answer for directories and files that can't be written, so the client isn't
+ * left to send a whole body first. put_publish checks again, and has the final say.
+ *
+ * @return 403 if the PUT is going to be refused, otherwise 0
+*/
+int put_check(const char *URI);
+
+/**
+ * @brief Replaces the file of a PUT with the temporary file its body was received into
+ *
+ * This is where the PUT takes effect, the caller should hold the writer lock of the URI. GETs
+ * that opened the file before keep reading the old version, and the file is dropped from the
+ * caches so later GETs see the new one. The temporary file is gone afterwards, whether it was
+ * published or not.
+ *
+ * @param tmp_path The temporary file
+ * @param URI The file to replace
+ * @param obj The new response to write through to the object cache (the caller keeps its
+ * reference), NULL if the file is not to be cached
+ * @return The status to respond with: 200 if the file was replaced, 201 if it was created
+*/
+int put_publish(const char *tmp_path, const char *URI, CachedObject *obj);
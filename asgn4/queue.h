@@ -57,3 +57,8 @@ bool queue_push(queue_t *q, void *elem);
  *          should succeed unless the q parameter is NULL.
  */
 bool queue_pop(queue_t *q, void **elem);
+
+// asgn4 builds its queue from ../asgn3/queue_lockfree.c, which also has bulk operations,
+// see asgn3/queue.h for what they do
+bool queue_push_many(queue_t *q, void **elems, int n);
+int queue_pop_many(queue_t *q, void **elems, int n);
@@ -0,0 +1,198 @@
+#include "seb_fdcache.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static pthread_mutex_t _mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t _capacity = 0;
+static size_t _count = 0;
+
+// hash table of the cached entries, _mask + 1 buckets (a power of two)
+static CachedFile **_buckets = NULL;
+static size_t _mask = 0;
+
+// LRU list of the cached entries, evictions take from the tail
+static CachedFile *_head = NULL;
+static CachedFile *_tail = NULL;
+
+static size_t uri_hash(const char *uri) {
+    // FNV-1a
+    size_t h = 2166136261u;
+    for (; *uri != '\0'; uri++) {
+        h = (h ^ (unsigned char) *uri) * 16777619u;
+    }
+    return h & _mask;
+}
+
+static void lru_unlink(CachedFile *f) {
+    if (f->prev != NULL) {
+        f->prev->next = f->next;
+    } else {
+        _head = f->next;
+    }
+    if (f->next != NULL) {
+        f->next->prev = f->prev;
+    } else {
+        _tail = f->prev;
+    }
+    f->prev = f->next = NULL;
+}
+
+static void lru_push_front(CachedFile *f) {
+    f->prev = NULL;
+    f->next = _head;
+    if (_head != NULL) {
+        _head->prev = f;
+    } else {
+        _tail = f;
+    }
+    _head = f;
+}
+
+// returns a pointer to the link pointing at the entry of uri, which is NULL if there is none
+static CachedFile **find(const char *uri) {
+    CachedFile **link = &_buckets[uri_hash(uri)];
+    while (*link != NULL && strcmp((*link)->uri, uri) != 0) {
+        link = &(*link)->chain;
+    }
+    return link;
+}
+
+static void entry_free(CachedFile *f) {
+    close(f->fd);
+    free(f->uri);
+    free(f);
+}
+
+// takes the entry at link out of the cache, returns whether the caller must free it
+// (the caller does so after unlocking, closing a file can take a while)
+static bool remove_at(CachedFile **link) {
+    CachedFile *f = *link;
+    *link = f->chain;
+    lru_unlink(f);
+    f->cached = false;
+    _count--;
+    return --f->refs == 0;
+}
+
+void fdcache_init(const size_t capacity) {
+    _capacity = capacity;
+    if (capacity == 0) {
+        return;
+    }
+
+    // keep the chains short, at least two buckets per entry
+    size_t buckets = 1;
+    while (buckets < capacity * 2) {
+        buckets <<= 1;
+    }
+    _buckets = calloc(buckets, sizeof(CachedFile *));
+    _mask = buckets - 1;
+
+    if (_buckets == NULL) {
+        _capacity = 0;
+    }
+}
+
+CachedFile *fdcache_get(const char *uri) {
+    if (_capacity == 0) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&_mutex);
+    CachedFile *f = *find(uri);
+    if (f != NULL) {
+        f->refs++;
+        lru_unlink(f);
+        lru_push_front(f);
+    }
+    pthread_mutex_unlock(&_mutex);
+
+    return f;
+}
+
+CachedFile *fdcache_insert(const char *uri, const int fd, const struct stat *st) {
+    CachedFile *f = calloc(1, sizeof(CachedFile));
+    if (f == NULL || (f->uri = strdup(uri)) == NULL) {
+        free(f);
+        return NULL;
+    }
+
+    f->fd = fd;
+    f->st = *st;
+    f->refs = 1;
+
+    if (_capacity == 0) {
+        // not cached, the file is closed when this reference is given back
+        return f;
+    }
+
+    CachedFile *evicted = NULL;
+
+    pthread_mutex_lock(&_mutex);
+    CachedFile **link = find(uri);
+    CachedFile *existing = *link;
+
+    if (existing != NULL) {
+        // another GET opened it at the same time, share theirs
+        existing->refs++;
+        lru_unlink(existing);
+        lru_push_front(existing);
+    } else {
+        if (_count == _capacity) {
+            CachedFile *victim = _tail;
+            if (remove_at(find(victim->uri))) {
+                evicted = victim;
+            }
+            // the victim may have been on the same chain, find the end again
+            link = find(uri);
+        }
+
+        // the cache holds its own reference
+        f->refs++;
+        f->cached = true;
+        *link = f;
+        lru_push_front(f);
+        _count++;
+    }
+    pthread_mutex_unlock(&_mutex);
+
+    if (evicted != NULL) {
+        entry_free(evicted);
+    }
+
+    if (existing != NULL) {
+        entry_free(f);
+        return existing;
+    }
+    return f;
+}
+
+void fdcache_release(CachedFile *file) {
+    pthread_mutex_lock(&_mutex);
+    const bool last = --file->refs == 0;
+    pthread_mutex_unlock(&_mutex);
+
+    if (last) {
+        entry_free(file);
+    }
+}
+
+void fdcache_invalidate(const char *uri) {
+    if (_capacity == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&_mutex);
+    CachedFile **link = find(uri);
+    CachedFile *f = *link;
+    const bool last = f != NULL && remove_at(link);
+    pthread_mutex_unlock(&_mutex);
+
+    if (last) {
+        entry_free(f);
+    }
+}
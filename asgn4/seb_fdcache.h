@@ -0,0 +1,77 @@
+/**
+ * @file seb_fdcache.h
+ *
+ * A bounded cache of open files and their stat, keyed by URI, for GET
+ *
+ * A hot file is opened and stat'ed once, and every GET of it shares the one file descriptor.
+ * That is safe because GETs only send with explicit offsets (sendfile, pread, mmap), never
+ * through the file offset. Entries are reference counted: evicting or invalidating an entry
+ * only closes its file once the last GET using it is done.
+ *
+ * The cache does not notice files changing behind its back. A PUT must invalidate the URI
+ * while holding its writer lock, after the new file is in place, so the GETs ordered after it
+ * open the new file.
+ *
+ * All functions are thread safe.
+ *
+ * @author Sebastian Law
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/stat.h>
+
+/**
+ * @struct CachedFile
+ * @brief An open file, shared by the GETs holding a reference to it
+ *
+ * Holders may read fd and st, the rest belongs to the cache.
+*/
+typedef struct cached_file {
+    int fd;
+    struct stat st;
+
+    char *uri;
+    // one for every holder, plus one for the cache itself while the entry is in it
+    int refs;
+    bool cached;
+    // the hash chain, and the LRU list (most recently used first)
+    struct cached_file *chain;
+    struct cached_file *prev;
+    struct cached_file *next;
+} CachedFile;
+
+/**
+ * @brief Sets up the cache, call once at startup
+ *
+ * @param capacity The most files kept open, 0 disables caching (every GET opens its own file)
+*/
+void fdcache_init(const size_t capacity);
+
+/**
+ * @brief Looks up a URI, returns a reference to its file, or NULL if it isn't cached
+*/
+CachedFile *fdcache_get(const char *uri);
+
+/**
+ * @brief Adds a file the caller opened and stat'ed, returns a reference to it
+ *
+ * The cache takes the file descriptor over. If the URI got cached in the meantime, the existing
+ * entry is returned and fd is closed. When the cache is full, the least recently used entry is
+ * evicted.
+ *
+ * @return A reference, or NULL (and fd is still the caller's) if out of memory
+*/
+CachedFile *fdcache_insert(const char *uri, const int fd, const struct stat *st);
+
+/**
+ * @brief Gives back a reference from fdcache_get or fdcache_insert
+*/
+void fdcache_release(CachedFile *file);
+
+/**
+ * @brief Drops a URI from the cache, the next fdcache_get of it misses
+*/
+void fdcache_invalidate(const char *uri);
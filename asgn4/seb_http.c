@@ -1,31 +1,37 @@
 #include "seb_http.h"
 
-#include "asgn2_helper_funcs.h"
+#include "seb_http_grammar.h"
+#include "seb_http_tables.h"
+#include "seb_scan.h"
 
 #include <sys/socket.h>
 
+#include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 
-#include <regex.h>
+// how much is drained from the socket before closing it, see req_close
+#define _BUF_EXTRA 256
 
-// try to parse a chunk of data using a regex pattern with n_groups
-#define try_parse_chunk(req, chunk_size, pattern, n_groups)                                        \
-    regmatch_t matches[n_groups];                                                                  \
-    const int res = parse_chunk(req, chunk_size, pattern, matches, n_groups);                      \
-    if (res != 0) {                                                                                \
-        return res;                                                                                \
-    }
+// Input buffers come in power-of-two size classes, from 1 KB up to the first at least
+// REQ_MAX_SIZE_LIMIT (32 KB)
+#define _BUF_MIN_SHIFT 10
+#define _BUF_NUM_CLASSES 6
+#define _BUF_CLASS_SIZE(cls) ((bufsize_t) 1 << ((cls) + _BUF_MIN_SHIFT))
 
-#define _BUF_EXTRA 256
+// The pools keep at most this many bytes of free buffers per size class
+#define _POOL_MAX_BYTES (1024 * 1024)
 
 typedef struct {
-    // the string buffer itself
-    // to make sure we never segfault,
-    // we'll make this buffer a bit larger than the maximum request size
-    char buf[REQ_MAX_SIZE + _BUF_EXTRA];
+    // the string buffer itself, NULL until the first read
+    // buffers are taken from the pools below, and swapped for a larger one as the headers grow
+    char *buf;
+    // the size class of buf, -1 if there is no buffer
+    int cls;
 
     // "parse cursor"
     // the current position in the buffer to start parsing from
@@ -43,12 +49,22 @@ struct request {
     // socket file descriptor
     int sockfd;
 
+    // Whether parsing is finished, and if so whether the request was valid
+    ParseStatus status;
+
+    // The current state of the request DFA
+    unsigned short dfa_state;
+    // The part of the request the DFA is currently in
+    ReqTag tag;
+    // Where in the buffer the current part started
+    bufsize_t part_start;
+
     // The HTTP method used in the request
     Method method;
 
-    // The URI of the request
-    // This string is null-terminated
-    char *uri;
+    // Offset of the URI in the input buffer, -1 until it has been parsed
+    // The URI is null-terminated in place
+    bufsize_t uri;
 
     // The Major version of the HTTP request
     char http_ver_major;
@@ -58,10 +74,19 @@ struct request {
     // The number of headers in the request
     int num_headers;
 
+    // For each KnownHeader, the index of the first such header in headers, or -1
+    signed char known[HDR_NUM_KNOWN];
+
+    // The value of the Content-Length header, see req_get_content_length
+    ssize_t content_length;
+
     // The headers in the request
-    // This array is num_headers long
-    // This array can be NULL if num_headers is 0
-    Header *headers;
+    // Only the first num_headers entries are valid
+    // Each header is a view into the input buffer, so nothing here needs to be freed
+    Header headers[REQ_MAX_HEADERS];
+
+    // Where the request line and headers end in the input buffer, once parsed
+    bufsize_t head_end;
 
     // The size of the body of the request
     bufsize_t body_size;
@@ -76,275 +101,380 @@ struct request {
      * NOTE: This is not guaranteed to be the full body, only the first body_size bytes.
      *       More data may be available from the socket.
     */
-    char *body;
-    // NOTE: The body pointer internally points to a location in the InputBuffer.
+    bufsize_t body;
+    // NOTE: The body is an offset into the InputBuffer, -1 if there is no body.
     //       This means that the body should not be freed separately from the request.
 };
 
-// public constructor and destructor functions
+// input buffer pools
 
-Request *req_create(const int sockfd) {
-    Request *req = malloc(sizeof(Request));
+// the limit on the request line and headers, see req_set_max_size
+static bufsize_t _max_size = REQ_MAX_SIZE;
 
-    req->in.pc = 0;
-    req->in.wc = 0;
+// a free buffer, linked through its own first bytes
+typedef struct pool_buf {
+    struct pool_buf *next;
+} PoolBuf;
 
-    req->sockfd = sockfd;
-    req->method = UNSUPPORTED;
+// the free buffers of one size class
+// shared by all threads: buffers are mostly taken on a reactor thread, while reading requests,
+// and given back on the workers that served them, so pools per thread would never be reused
+typedef struct {
+    pthread_mutex_t mutex;
+    PoolBuf *head;
+    int count;
+} Pool;
 
-    req->uri = NULL;
+static Pool _pools[_BUF_NUM_CLASSES];
+static pthread_once_t _pools_once = PTHREAD_ONCE_INIT;
 
-    req->http_ver_major = '0';
-    req->http_ver_minor = '0';
+static void pools_init(void) {
+    for (int i = 0; i < _BUF_NUM_CLASSES; i++) {
+        pthread_mutex_init(&_pools[i].mutex, NULL);
+    }
+}
 
-    req->num_headers = 0;
-    req->headers = NULL;
+static char *pool_get(const int cls) {
+    pthread_once(&_pools_once, pools_init);
+    Pool *pool = &_pools[cls];
 
-    req->body_size = 0;
-    req->body = NULL;
+    pthread_mutex_lock(&pool->mutex);
+    PoolBuf *pb = pool->head;
+    if (pb != NULL) {
+        pool->head = pb->next;
+        pool->count--;
+    }
+    pthread_mutex_unlock(&pool->mutex);
 
-    return req;
+    return pb != NULL ? (char *) pb : malloc(_BUF_CLASS_SIZE(cls));
 }
 
-void req_close(Request *req) {
-    // read the rest of the request
-    // this ensures the client has read our response before we close the connection
-    // directly raw recv() on the socket is the fastest way to do this.
-    recv(req->sockfd, req->in.buf + req->in.wc, _BUF_EXTRA, 0);
-    close(req->sockfd);
+static void pool_put(char *buf, const int cls) {
+    Pool *pool = &_pools[cls];
+    PoolBuf *pb = (PoolBuf *) buf;
+
+    pthread_mutex_lock(&pool->mutex);
+    const bool keep = pool->count < _POOL_MAX_BYTES / _BUF_CLASS_SIZE(cls);
+    if (keep) {
+        pb->next = pool->head;
+        pool->head = pb;
+        pool->count++;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (!keep) {
+        free(buf);
+    }
 }
 
-void req_free(Request *req) {
-    if (req->uri != NULL) {
-        free(req->uri);
+// makes sure the input buffer has room for more data, as long as it is under the limit
+// returns how much data can be written at the write cursor
+static bufsize_t buf_reserve(InputBuffer *in) {
+    if (in->buf == NULL) {
+        in->cls = 0;
+        in->buf = pool_get(0);
+    } else if (in->wc == _BUF_CLASS_SIZE(in->cls) && in->wc < _max_size) {
+        // full, move to the next size class up
+        // everything else in the request refers to the buffer by offset, so this is safe
+        char *buf = pool_get(in->cls + 1);
+        memcpy(buf, in->buf, in->wc);
+        pool_put(in->buf, in->cls);
+        in->buf = buf;
+        in->cls++;
     }
 
-    if (req->headers != NULL) {
-        for (int i = 0; i < req->num_headers; i++) {
-            free(req->headers[i].key);
-            free(req->headers[i].value);
-        }
+    const bufsize_t cap = _BUF_CLASS_SIZE(in->cls);
+    return (cap < _max_size ? cap : _max_size) - in->wc;
+}
 
-        free(req->headers);
+int req_set_max_size(const bufsize_t size) {
+    if (size < REQ_MAX_SIZE || size > REQ_MAX_SIZE_LIMIT) {
+        return -1;
     }
 
-    free(req);
+    _max_size = size;
+    return 0;
 }
 
-// internal parse functions
+bufsize_t req_get_max_size(void) {
+    return _max_size;
+}
 
-int parse_chunk(Request *req, const bufsize_t chunk_size, regex_t *reg, regmatch_t *matches,
-    const size_t n_matches) {
+// puts the parser back at the start of a request, leaves the input buffer alone
+static void reset_parse(Request *req) {
+    req->status = PARSE_AGAIN;
+    req->dfa_state = _DFA_START;
+    req->tag = TAG_NONE;
+    req->part_start = 0;
 
-    // The amount of data already read into the buffer that is not yet parsed
-    const bufsize_t cur_size = req->in.wc - req->in.pc;
+    req->method = UNSUPPORTED;
 
-    if (cur_size < chunk_size && req->in.wc < REQ_MAX_SIZE) {
-        // If there is not enough data in the buffer to parse the chunk, read more data
+    req->uri = -1;
 
-        // How much more data is needed to parse the chunk
-        bufsize_t need = chunk_size - cur_size;
+    req->http_ver_major = '0';
+    req->http_ver_minor = '0';
 
-        // If the requested read amount would exceed the maximum buffer size, read only up to the maximum buffer size
-        if (req->in.wc + need > REQ_MAX_SIZE) {
-            need = REQ_MAX_SIZE - req->in.wc;
-        }
+    req->num_headers = 0;
+    memset(req->known, -1, sizeof(req->known));
+    req->content_length = -1;
 
-        // Read the data from the socket
-        const ssize_t rb = read_n_bytes(req->sockfd, req->in.buf + req->in.wc, need);
-        switch (rb) {
-        case 0:
-        case -1:
-            // if no data is read or an error occurs, consider this an invalid request
-            return -1;
-        // if data is read, update the write cursor
-        default: req->in.wc += rb;
-        }
-    }
+    req->head_end = 0;
+    req->body_size = 0;
+    req->body = -1;
+}
 
-    // Assume that enough data is in the buffer to parse the chunk
+// public constructor and destructor functions
 
-    char str[req->in.wc - req->in.pc + 1];
-    strncpy(str, req->in.buf + req->in.pc, req->in.wc - req->in.pc);
-    str[req->in.wc - req->in.pc] = '\0';
+Request *req_create(const int sockfd) {
+    Request *req = malloc(sizeof(Request));
 
-    const int reg_res = regexec(reg, str, n_matches, matches, 0);
+    // the buffer is only taken from the pool once there is something to read into it
+    req->in.buf = NULL;
+    req->in.cls = -1;
+    req->in.pc = 0;
+    req->in.wc = 0;
 
-    if (reg_res != 0) {
-        // the pattern does not match, return bad request
-        return -1;
+    req->sockfd = sockfd;
+    reset_parse(req);
+
+    return req;
+}
+
+Request *req_create_from_buffer(const char *data, const size_t n) {
+    Request *req = req_create(-1);
+
+    // only copy what fits, the rest would be body data the buffer has no room for anyway
+    size_t copied = 0;
+    bufsize_t space;
+    while (copied < n && (space = buf_reserve(&req->in)) > 0) {
+        const bufsize_t len = n - copied < (size_t) space ? (bufsize_t) (n - copied) : space;
+        memcpy(req->in.buf + req->in.wc, data + copied, len);
+        req->in.wc += len;
+        copied += len;
     }
 
-    return 0;
+    return req;
 }
 
-/*
-A valid Method contains at most eight (8) characters from the character range [a-zA-Z]. Your server
-only needs to implement (i.e., perform the semantics) of GET and PUT.
-*/
-#define _METHOD_PATTERN "^([a-zA-Z]{1,8}) "
-// 8 alphabet characters max, plus 1 to include the trailing space
-#define _METHOD_CHUNK_LEN 9
-
-static regex_t *_METHOD_REG;
-
-int parse_method(Request *req) {
-    try_parse_chunk(req, _METHOD_CHUNK_LEN, _METHOD_REG, 2);
-
-    const bufsize_t method_len = matches[1].rm_eo - matches[1].rm_so;
-    char method_str[method_len + 1];
-    strncpy(method_str, req->in.buf + req->in.pc + matches[1].rm_so, method_len);
-    method_str[method_len] = '\0';
-
-    if (strcasecmp(method_str, "GET") == 0) {
-        req->method = GET;
-    } else if (strcasecmp(method_str, "PUT") == 0) {
-        req->method = PUT;
-    } else {
-        req->method = UNSUPPORTED;
+void req_close(Request *req) {
+    if (req->sockfd == -1) {
+        return;
     }
 
-    // move the parse cursor to the end of the match
-    req->in.pc += matches[0].rm_eo;
+    // tell the client we're done first, a client that keeps its connection open otherwise waits
+    // for our end to close as much as we'd wait for the rest of its request below
+    shutdown(req->sockfd, SHUT_WR);
 
-    return 0;
+    // read the rest of the request
+    // this ensures the client has read our response before we close the connection
+    // directly raw recv() on the socket is the fastest way to do this.
+    char drain[_BUF_EXTRA];
+    recv(req->sockfd, drain, sizeof(drain), 0);
+    close(req->sockfd);
 }
 
-/*
-A valid URI starts with the character ‘/’, includes at least 2 characters and at most 64 characters
-(including the ‘/’), and except for the leading ‘/’, only includes characters from the character set [a-zA-Z0-9.-]
-(this character set includes 64 total valid characters)
-*/
-#define _URI_PATTERN "^/([a-zA-Z0-9\\.-]{1,63}) "
-// 64 characters max, plus 1 to include the trailing space
-#define _URI_CHUNK_LEN 65
+void req_next(Request *req, const size_t body_len) {
+    InputBuffer *in = &req->in;
 
-static regex_t *_URI_REG;
+    // whatever was read past the body is the start of the next request
+    const size_t end = (size_t) req->head_end + body_len;
+    const bufsize_t left = end < (size_t) in->wc ? in->wc - (bufsize_t) end : 0;
 
-int parse_uri(Request *req) {
-    try_parse_chunk(req, _URI_CHUNK_LEN, _URI_REG, 2);
+    if (left > 0) {
+        memmove(in->buf, in->buf + end, left);
+    } else if (in->buf != NULL) {
+        // an idle connection doesn't need a buffer, it gets one again once there is data
+        pool_put(in->buf, in->cls);
+        in->buf = NULL;
+        in->cls = -1;
+    }
+    in->pc = 0;
+    in->wc = left;
 
-    const bufsize_t uri_len = matches[1].rm_eo - matches[1].rm_so;
-    // include 1 for null terminator
-    req->uri = malloc((uri_len + 1) * sizeof(char));
-    strncpy(req->uri, req->in.buf + req->in.pc + matches[1].rm_so, uri_len);
-    req->uri[uri_len] = '\0';
+    reset_parse(req);
+}
 
-    // move the parse cursor to the end of the match
-    req->in.pc += matches[0].rm_eo;
+bool req_has_data(const Request *req) {
+    return req->in.wc > 0;
+}
 
-    return 0;
+void req_free(Request *req) {
+    if (req->in.buf != NULL) {
+        pool_put(req->in.buf, req->in.cls);
+    }
+    free(req);
 }
 
-/*
-A valid Version has the format HTTP/#.#, where each # is a single digit number. Your httpserver
-should only implement version 1.1, so it should only perform the semantics of GET and PUT requests
-that include a version equal to HTTP/1.1.
-*/
-#define _HTTP_VERSION_PATTERN "^HTTP/([0-9])\\.([0-9])\r\n"
-// (HTTP/#.#\r\n) is 10 characters long, plus 1 to include the trailing space
-#define _HTTP_VERSION_CHUNK_LEN 11
+// internal parse functions
 
-static regex_t *_HTTP_VERSION_REG;
+// name lengths of the well-known headers
+static const bufsize_t _known_header_len[HDR_NUM_KNOWN] = {
+#define _KNOWN_HEADER_LEN(id, name) sizeof(name) - 1,
+    KNOWN_HEADERS(_KNOWN_HEADER_LEN)
+#undef _KNOWN_HEADER_LEN
+};
 
-int parse_http_version(Request *req) {
-    try_parse_chunk(req, _HTTP_VERSION_CHUNK_LEN, _HTTP_VERSION_REG, 3);
+static const char *const _known_header_name[HDR_NUM_KNOWN] = {
+#define _KNOWN_HEADER_NAME(id, name) name,
+    KNOWN_HEADERS(_KNOWN_HEADER_NAME)
+#undef _KNOWN_HEADER_NAME
+};
 
-    req->http_ver_major = req->in.buf[req->in.pc + matches[1].rm_so];
-    req->http_ver_minor = req->in.buf[req->in.pc + matches[2].rm_so];
+// returns which well-known header a key is, or -1 if it is not one
+// the perfect hash (_HDR_HASH, _hdr_slot) is generated by gen_http_tables
+static int find_known_header(const char *key, const bufsize_t len) {
+    if (len == 0 || len > _HDR_MAX_LEN) {
+        return -1;
+    }
 
-    // move the parse cursor to the end of the match
-    req->in.pc += matches[0].rm_eo;
+    const int slot = _hdr_slot[_HDR_HASH(len, key[0] | 0x20, key[len - 1] | 0x20)];
+    if (slot == -1 || _known_header_len[slot] != len
+        || strncasecmp(key, _known_header_name[slot], len) != 0) {
+        return -1;
+    }
 
-    return 0;
+    return slot;
 }
 
-/*
-Valid requests include zero (0) or more header-fields after request-line.
-A header-field is a key-value pair with the format:
-
-key: value\r\n
-
-• The key ends with the first instance of a ‘:’ character. A valid request’s header-field keys will be at least
-1 character, at most 128 characters, and only contain characters from the character set [a-zA-Z0-9.-].
-
-• A valid request’s header-field values will contain at most 128 characters and only contain characters
-from the set of printable ASCII characters (i.e., a valid value will not contain any ASCII “Device
-Control” characters nor any other binary data).
-
-• Valid requests separate each header-field using the sequence \r\n, and will terminate the list
-of header-fields with a blank header terminating in \r\n. (Essentially, regardless of how many
-header-fields a request contains, the list will terminate with the sequence \r\n\r\n).
-*/
+// helper to convert a string of len characters to long, returns -1 if invalid
+// we need this because sscanf stops parsing before the end of the string in a lot of cases
+static ssize_t _str_to_long(const char *str, const bufsize_t len) {
+    ssize_t res = 0;
+    for (bufsize_t i = 0; i < len; i++) {
+        res *= 10;
+        switch (str[i]) {
+        case '1': res += 1; break;
+        case '2': res += 2; break;
+        case '3': res += 3; break;
+        case '4': res += 4; break;
+        case '5': res += 5; break;
+        case '6': res += 6; break;
+        case '7': res += 7; break;
+        case '8': res += 8; break;
+        case '9': res += 9;
+        case '0': continue;
+        default: return -1;
+        }
+    }
+    return res;
+}
 
-// printable ascii characters are in the range [ -~] (32-126, inclusive, ASCII space to tilde)
+// called whenever the DFA leaves a tagged part of the request
+// the part occupies [start, end) in the input buffer, and the byte at end has already been consumed
+// returns -1 if the part cannot be stored
+static int end_part(Request *req, const ReqTag tag, const bufsize_t start, const bufsize_t end) {
+    char *part = req->in.buf + start;
+    const bufsize_t len = end - start;
+    int known;
+
+    switch (tag) {
+    case TAG_METHOD:
+        if (len == 3 && strncasecmp(part, "GET", 3) == 0) {
+            req->method = GET;
+        } else if (len == 3 && strncasecmp(part, "PUT", 3) == 0) {
+            req->method = PUT;
+        } else {
+            req->method = UNSUPPORTED;
+        }
+        break;
 
-#define _HEADERS_PATTERN "^([a-zA-Z0-9\\.-]{1,128}: [ -~]{1,128}\r\n)*\r\n"
-// 0 since we are going to circumvent the chunking of read_n_bytes
-// by reading as much as possible using recv() directly
-#define _HEADERS_CHUNK_LEN 0
+    case TAG_URI:
+        // null-terminate in place, overwriting the space after the URI
+        req->uri = start;
+        part[len] = '\0';
+        break;
 
-static regex_t *_HEADERS_REG;
+    case TAG_VER_MAJOR: req->http_ver_major = *part; break;
+    case TAG_VER_MINOR: req->http_ver_minor = *part; break;
 
-// Pattern that matches a single header
-#define _HEADER_PATTERN "([a-zA-Z0-9\\.-]{1,128}): ([ -~]{1,128})\r\n"
+    case TAG_KEY:
+        // a key always starts a new header
+        if (req->num_headers == REQ_MAX_HEADERS) {
+            return -1;
+        }
 
-static regex_t *_HEADER_REG;
+        // only the first of each well-known header is indexed
+        known = find_known_header(part, len);
+        if (known != -1 && req->known[known] == -1) {
+            req->known[known] = req->num_headers;
+        }
 
-int parse_headers(Request *req) {
-    try_parse_chunk(req, _HEADERS_CHUNK_LEN, _HEADERS_REG, 2);
+        // null-terminate in place, overwriting the ':'
+        req->headers[req->num_headers].key = start;
+        req->headers[req->num_headers].key_len = len;
+        req->num_headers++;
+        part[len] = '\0';
+        break;
+
+    case TAG_VALUE:
+        // the value belongs to the header whose key was just parsed
+        // null-terminate in place, overwriting the '\r'
+        req->headers[req->num_headers - 1].value = start;
+        req->headers[req->num_headers - 1].value_len = len;
+        part[len] = '\0';
+
+        if (req->known[HDR_CONTENT_LENGTH] == req->num_headers - 1) {
+            // string is not a positive number consisting of only digits (invalid)
+            const ssize_t content_length = _str_to_long(part, len);
+            req->content_length = content_length < 0 ? -2 : content_length;
+        }
+        break;
 
-    if (matches[1].rm_so == matches[1].rm_eo) {
-        // no headers, move the parse cursor to the end of the match, and return
-        req->in.pc += matches[0].rm_eo;
-        return 0;
+    case TAG_NONE:
+    case TAG_HEADER: break;
     }
 
-    int num_headers = 0;
-    Header *headers = malloc(0);
+    return 0;
+}
 
-    const regoff_t headers_end = req->in.pc + matches[1].rm_eo;
+/**
+ * Runs the request DFA (see seb_http_grammar.h) over the unparsed data in the buffer.
+ *
+ * Returns 1 once the request line and headers are complete, 0 if more data is needed,
+ * and -1 if the request is invalid.
+*/
+static int parse_advance(Request *req) {
+    InputBuffer *in = &req->in;
+    unsigned int state = req->dfa_state;
 
-    // iterate over matches
-    for (regmatch_t header_match[3]; req->in.pc < headers_end; num_headers++) {
-        // group 1: key
-        // group 2: value
-        const int reg_res = regexec(_HEADER_REG, req->in.buf + req->in.pc, 3, header_match, 0);
-        if (reg_res != 0) {
-            // *somehow* the pattern doesn't match, return bad request
-            free(headers);
+    while (in->pc < in->wc) {
+        state = _dfa_next[state][_dfa_class[(unsigned char) in->buf[in->pc]]];
+        if (state == _DFA_DEAD) {
             return -1;
         }
 
-        const bufsize_t key_len = header_match[1].rm_eo - header_match[1].rm_so;
-        const bufsize_t value_len = header_match[2].rm_eo - header_match[2].rm_so;
-
-        // allocate space for the new header
-        headers = realloc(headers, (num_headers + 1) * sizeof(Header));
-
-        // the new header
-        Header *header = &headers[num_headers];
+        if (_dfa_tag[state] != req->tag) {
+            if (end_part(req, req->tag, req->part_start, in->pc) != 0) {
+                return -1;
+            }
+            req->tag = _dfa_tag[state];
+            req->part_start = in->pc;
+        }
 
-        // copy the key and value into the new header
-        header->key = malloc((key_len + 1) * sizeof(char));
-        strncpy(header->key, req->in.buf + req->in.pc + header_match[1].rm_so, key_len);
-        header->key[key_len] = '\0';
+        in->pc++;
 
-        // copy the value into the new header
-        header->value = malloc((value_len + 1) * sizeof(char));
-        strncpy(header->value, req->in.buf + req->in.pc + header_match[2].rm_so, value_len);
-        header->value[value_len] = '\0';
+        if (_dfa_accept[state]) {
+            // the parse cursor is now at the start of the body
+            req->dfa_state = state;
+            return 1;
+        }
 
-        // move the parse cursor to the end of the match
-        req->in.pc += header_match[0].rm_eo;
+        if (_dfa_run_len[state] > 0) {
+            // inside a run of one character class (e.g. a header value), the states are
+            // consecutive, so find where the run ends with a vectorized scan and jump there.
+            // the delimiter that ends the run goes through the table as usual.
+            bufsize_t avail = in->wc - in->pc;
+            if (avail > _dfa_run_len[state]) {
+                avail = _dfa_run_len[state];
+            }
+
+            const bufsize_t run = scan_span(_dfa_run_class[state], in->buf + in->pc, avail);
+            state += run;
+            in->pc += run;
+        }
     }
 
-    req->num_headers = num_headers;
-    req->headers = headers;
-
-    // move the parse cursor to the end of the match
-    req->in.pc += 2; // 2 for the \r\n
-
+    req->dfa_state = state;
     return 0;
 }
 
@@ -354,7 +484,7 @@ int parse_body(Request *req) {
 
     if (cur_size > 0) {
         req->body_size = cur_size;
-        req->body = req->in.buf + req->in.pc;
+        req->body = req->in.pc;
     }
 
     // move the parse cursor up to the write cursor
@@ -363,36 +493,104 @@ int parse_body(Request *req) {
     return 0;
 }
 
-// public parse function
+// public parse functions
 
-int req_parse(Request *req) {
-    if (parse_method(req) != 0) {
-        return -1;
-    }
+ParseStatus req_parse_commit(Request *req, const bufsize_t n) {
+    req->in.wc += n;
 
-    if (parse_uri(req) != 0) {
-        return -1;
+    if (req->status != PARSE_AGAIN) {
+        return req->status;
     }
 
-    if (parse_http_version(req) != 0) {
-        return -1;
+    switch (parse_advance(req)) {
+    case 1:
+        req->head_end = req->in.pc;
+        parse_body(req);
+        req->status = PARSE_DONE;
+        break;
+    case -1: req->status = PARSE_INVALID; break;
+    default:
+        if (req->in.wc >= _max_size) {
+            // the request line and headers do not fit in the buffer
+            req->status = PARSE_INVALID;
+        }
+        break;
     }
 
-    // read as much as possible from the socket
-    const ssize_t rb = recv(req->sockfd, req->in.buf + req->in.wc, REQ_MAX_SIZE - req->in.wc, 0);
-    if (rb > 0) {
-        req->in.wc += rb;
+    return req->status;
+}
+
+char *req_read_buf(Request *req, bufsize_t *space) {
+    *space = buf_reserve(&req->in);
+    return req->in.buf + req->in.wc;
+}
+
+ParseStatus req_feed(Request *req, const char *data, const size_t n) {
+    // a buffer at a time, it only grows once the one it has is full
+    size_t fed = 0;
+    bufsize_t space;
+    while (fed < n && req->status == PARSE_AGAIN) {
+        char *dst = req_read_buf(req, &space);
+        if (space == 0) {
+            break;
+        }
+
+        const bufsize_t len = n - fed < (size_t) space ? (bufsize_t) (n - fed) : space;
+        memcpy(dst, data + fed, len);
+        fed += len;
+        req_parse_commit(req, len);
     }
 
-    if (parse_headers(req) != 0) {
-        return -1;
+    // what is left once the head is parsed is body data, past what the buffer already holds
+    return req->status;
+}
+
+ParseStatus req_parse_nb(Request *req) {
+    while (req->status == PARSE_AGAIN) {
+        bufsize_t space;
+        char *dst = req_read_buf(req, &space);
+
+        const ssize_t rb = recv(req->sockfd, dst, space, MSG_DONTWAIT);
+        if (rb == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // nothing more to read right now, the parse state is kept for the next call
+            return PARSE_AGAIN;
+        }
+        if (rb <= 0) {
+            // if the connection is closed or an error occurs, consider this an invalid request
+            req->status = PARSE_INVALID;
+            break;
+        }
+
+        req_parse_commit(req, rb);
     }
 
-    if (parse_body(req) != 0) {
-        return -1;
+    return req->status;
+}
+
+int req_parse(Request *req) {
+    // parse whatever is already buffered first
+    req_parse_commit(req, 0);
+
+    while (req->status == PARSE_AGAIN) {
+        if (req->sockfd == -1) {
+            // created from a buffer, there is nothing more to read
+            return -1;
+        }
+
+        bufsize_t space;
+        char *dst = req_read_buf(req, &space);
+
+        // read as much as possible from the socket
+        const ssize_t rb = recv(req->sockfd, dst, space, 0);
+        if (rb <= 0) {
+            // if no data is read or an error occurs, consider this an invalid request
+            return -1;
+        }
+
+        req_parse_commit(req, rb);
     }
 
-    return 0;
+    return req->status == PARSE_DONE ? 0 : -1;
 }
 
 // public getters
@@ -406,7 +604,11 @@ Method req_get_method(const Request *req) {
 }
 
 char *req_get_uri(const Request *req) {
-    return req->uri;
+    if (req->uri == -1) {
+        return NULL;
+    }
+
+    return (char *) req->in.buf + req->uri;
 }
 
 char req_get_http_ver_major(const Request *req) {
@@ -421,57 +623,134 @@ int req_get_num_headers(const Request *req) {
     return req->num_headers;
 }
 
-Header *req_get_headers(const Request *req) {
+const Header *req_get_headers(const Request *req) {
     return req->headers;
 }
 
+char *req_get_header_key(const Request *req, const Header *header) {
+    return (char *) req->in.buf + header->key;
+}
+
+char *req_get_header_value_of(const Request *req, const Header *header) {
+    return (char *) req->in.buf + header->value;
+}
+
+char *req_get_known_header(const Request *req, const KnownHeader header) {
+    if (req->known[header] == -1) {
+        return NULL;
+    }
+
+    return req_get_header_value_of(req, &req->headers[req->known[header]]);
+}
+
 char *req_get_header_value(const Request *req, const char *key) {
+    const size_t key_len = strlen(key);
+
+    const int known = find_known_header(key, key_len);
+    if (known != -1) {
+        return req_get_known_header(req, known);
+    }
+
+    // not a well-known header, search for it
+
     for (int i = 0; i < req->num_headers; i++) {
-        if (strcasecmp(req->headers[i].key, key) == 0) {
-            return req->headers[i].value;
+        const Header *header = &req->headers[i];
+        if ((size_t) header->key_len == key_len
+            && strncasecmp(req->in.buf + header->key, key, key_len) == 0) {
+            return req_get_header_value_of(req, header);
         }
     }
 
     return NULL;
 }
 
-// helper to convert string to long, returns -1 if invalid
-// we need this because sscanf stops parsing before null-terminator in a lot of cases
-ssize_t _str_to_long(const char *str) {
-    ssize_t res = 0;
-    for (unsigned int i = 0; str[i] != '\0'; i++) {
-        res *= 10;
-        switch (str[i]) {
-        case '1': res += 1; break;
-        case '2': res += 2; break;
-        case '3': res += 3; break;
-        case '4': res += 4; break;
-        case '5': res += 5; break;
-        case '6': res += 6; break;
-        case '7': res += 7; break;
-        case '8': res += 8; break;
-        case '9': res += 9;
-        case '0': continue;
-        default: return -1;
+ssize_t req_get_content_length(const Request *req) {
+    return req->content_length;
+}
+
+bool req_keep_alive(const Request *req) {
+    const char *connection = req_get_known_header(req, HDR_CONNECTION);
+    if (connection == NULL) {
+        // persistent is the default in HTTP/1.1
+        return true;
+    }
+
+    // a list of options, any of them may be close
+    const char *p = connection;
+    while (*p != '\0') {
+        while (*p == ' ' || *p == ',') {
+            p++;
         }
+        const size_t len = strcspn(p, " ,");
+        if (len == 5 && strncasecmp(p, "close", 5) == 0) {
+            return false;
+        }
+        p += len;
     }
-    return res;
+    return true;
 }
 
-ssize_t req_get_content_length(const Request *req) {
-    const char *content_length_str = req_get_header_value(req, "Content-Length");
-    if (content_length_str == NULL) {
-        // no content-length header
-        return -1;
+// parses the digits at *p into *n, returns false if there are none or too many
+static bool parse_range_number(const char **p, long long *n) {
+    const char *start = *p;
+    *n = 0;
+    while (**p >= '0' && **p <= '9') {
+        if (*p - start >= 18) {
+            // would overflow, no file is that large anyway
+            return false;
+        }
+        *n = *n * 10 + (**p - '0');
+        (*p)++;
     }
+    return *p > start;
+}
 
-    const ssize_t content_length = _str_to_long(content_length_str);
-    if (content_length < 0) {
-        // string is not a positive number consisting of only digits (invalid)
-        return -2;
+int req_get_ranges(const Request *req, ByteRange *ranges, const int max) {
+    const char *p = req_get_known_header(req, HDR_RANGE);
+    if (p == NULL || strncasecmp(p, "bytes=", 6) != 0) {
+        return 0;
     }
+    p += 6;
+
+    int n = 0;
+    while (true) {
+        while (*p == ' ') {
+            p++;
+        }
 
-    return content_length;
+        ByteRange r = {-1, -1};
+        if (*p == '-') {
+            // suffix range, -last
+            p++;
+            if (!parse_range_number(&p, &r.last)) {
+                return 0;
+            }
+        } else {
+            // first-last, or first- to the end
+            if (!parse_range_number(&p, &r.first) || *p++ != '-') {
+                return 0;
+            }
+            if (*p >= '0' && *p <= '9'
+                && (!parse_range_number(&p, &r.last) || r.last < r.first)) {
+                return 0;
+            }
+        }
+
+        if (n == max) {
+            return 0;
+        }
+        ranges[n++] = r;
+
+        while (*p == ' ') {
+            p++;
+        }
+        if (*p == '\0') {
+            return n;
+        }
+        if (*p++ != ',') {
+            return 0;
+        }
+    }
 }
 
 bufsize_t req_get_body_size(const Request *req) {
@@ -479,35 +758,9 @@ bufsize_t req_get_body_size(const Request *req) {
 }
 
 char *req_get_body(const Request *req) {
-    return req->body;
-}
-
-// public regex initialization and cleanup functions
-static regex_t _regs[5];
-static int _regs_initialized = 0;
-
-void seb_http_regex_cleanup() {
-    for (int i = 0; i < _regs_initialized; i++) {
-        regfree(&_regs[i]);
-    }
-}
-
-#define INIT_REGEX(reg)                                                                            \
-    if (regcomp(&_regs[_regs_initialized], _##reg##_PATTERN, REG_EXTENDED | REG_NEWLINE) != 0) {   \
-        seb_http_regex_cleanup();                                                                  \
-        fprintf(stderr, "Failed to initialize %s regex pattern (%s)\n", #reg, _##reg##_PATTERN);   \
-        return -1;                                                                                 \
-    } else {                                                                                       \
-        _##reg##_REG = &_regs[_regs_initialized++];                                                \
+    if (req->body == -1) {
+        return NULL;
     }
 
-int seb_http_regex_init() {
-    INIT_REGEX(METHOD);
-    INIT_REGEX(URI);
-    INIT_REGEX(HTTP_VERSION);
-    INIT_REGEX(HEADERS);
-    INIT_REGEX(HEADER);
-    return 0;
+    return req->in.buf + req->body;
 }
-
-#undef INIT_REGEX
@@ -11,9 +11,17 @@
 #include <stdbool.h>
 #include <stdio.h>
 
-// Request max size as defined by the assignment
+// Default limit on the size of the request line and headers, as defined by the assignment
 #define REQ_MAX_SIZE 2048
-// int is currently large enough to describe positions in the buffer (2048)
+
+// Maximum number of headers stored for a request, requests with more are rejected
+#define REQ_MAX_HEADERS 64
+
+// The largest limit that can be set with req_set_max_size: the largest valid request line and
+// headers. The grammar (seb_http_grammar.h) allows a request line of at most 84 bytes, and headers
+// of at most 260 (a 128 byte key and value, ": " and CRLF), so a larger limit would never be used
+#define REQ_MAX_SIZE_LIMIT (84 + REQ_MAX_HEADERS * 260 + 2)
+// int is large enough to describe positions in the buffer (REQ_MAX_SIZE_LIMIT)
 typedef int bufsize_t;
 
 /**
@@ -26,18 +34,63 @@ typedef enum {
     UNSUPPORTED,
 } Method;
 
+/**
+ * The well-known headers, which the parser indexes as it goes so they can be found in O(1)
+ *
+ * X(id, name) for each header, see KnownHeader
+*/
+#define KNOWN_HEADERS(X)                                                                           \
+    X(HDR_CONTENT_LENGTH, "Content-Length")                                                        \
+    X(HDR_REQUEST_ID, "Request-Id")                                                                \
+    X(HDR_HOST, "Host")                                                                            \
+    X(HDR_CONNECTION, "Connection")                                                                \
+    X(HDR_RANGE, "Range")                                                                          \
+    X(HDR_IF_NONE_MATCH, "If-None-Match")                                                          \
+    X(HDR_IF_MODIFIED_SINCE, "If-Modified-Since")                                                  \
+    X(HDR_EXPECT, "Expect")                                                                        \
+    X(HDR_TRANSFER_ENCODING, "Transfer-Encoding")
+
+/**
+ * @enum KnownHeader
+ * @brief Enumerated type for the well-known headers
+*/
+typedef enum {
+#define _KNOWN_HEADER_ID(id, name) id,
+    KNOWN_HEADERS(_KNOWN_HEADER_ID)
+#undef _KNOWN_HEADER_ID
+        HDR_NUM_KNOWN,
+} KnownHeader;
+
+/**
+ * @enum ParseStatus
+ * @brief Result of feeding data to the incremental request parser
+*/
+typedef enum {
+    // The request is invalid
+    PARSE_INVALID = -1,
+    // The request line and headers have been parsed
+    PARSE_DONE = 0,
+    // More data is needed, the parser keeps its state until it arrives
+    PARSE_AGAIN = 1,
+} ParseStatus;
+
 /**
  * @struct Header
  * @brief Structure that contains information about a HTTP header
+ *
+ * A header does not own any memory, its key and value are views into the input buffer of the
+ * Request it belongs to. Use req_get_header_key and req_get_header_value_of to access them.
 */
 typedef struct {
-    // The header's key
-    // This string is null-terminated
-    char *key;
+    // Offset of the header's key in the input buffer
+    bufsize_t key;
+    // Length of the key
+    bufsize_t key_len;
 
-    // The header's value
-    // This string is null-terminated
-    char *value;
+    // Offset of the header's value in the input buffer
+    bufsize_t value;
+    // Length of the value
+    bufsize_t value_len;
 } Header;
 
 /**
@@ -46,6 +99,22 @@ typedef struct {
 */
 typedef struct request Request;
 
+/**
+ * @brief Sets the limit on the size of the request line and headers
+ *
+ * Requests whose headers do not fit in this many bytes are invalid.
+ * This should be called once at startup, before any requests are created.
+ *
+ * @param size The new limit, between REQ_MAX_SIZE and REQ_MAX_SIZE_LIMIT
+ * @return 0 on success, -1 if the size is out of range
+*/
+int req_set_max_size(const bufsize_t size);
+
+/**
+ * @brief Returns the limit on the size of the request line and headers
+*/
+bufsize_t req_get_max_size(void);
+
 /**
  * @brief Creates a new Request structure from a socket file descriptor
  *
@@ -53,12 +122,41 @@ typedef struct request Request;
 */
 Request *req_create(const int sockfd);
 
+/**
+ * @brief Creates a new Request structure from a buffer in memory
+ *
+ * The data is copied into the request (up to req_get_max_size() bytes), and req_parse parses it
+ * without touching any socket. A request that is incomplete in data is invalid.
+ * req_get_sockfd returns -1 for such a request, and req_close does nothing.
+ *
+ * @param data The raw request bytes
+ * @param n The number of bytes in data
+*/
+Request *req_create_from_buffer(const char *data, const size_t n);
+
 /**
  * @brief Cleanly closes the underlying socket file descriptor
  * @param req The Request structure to close the socket of
 */
 void req_close(Request *req);
 
+/**
+ * @brief Readies the request to parse the next request on the same connection
+ *
+ * The parse state is reset, and the bytes read past the body of the current request are kept
+ * as the start of the next one. The caller must have consumed the whole body from the socket,
+ * e.g. with the body of a PUT, or it would be parsed as the next request.
+ *
+ * @param req The Request structure to reuse
+ * @param body_len The length of the body of the current request, 0 if it has none
+*/
+void req_next(Request *req, const size_t body_len);
+
+/**
+ * @brief Returns whether any bytes of the next request are already buffered, see req_next
+*/
+bool req_has_data(const Request *req);
+
 /**
  * @brief Closes the connection and frees the Request structure
  *
@@ -82,6 +180,56 @@ int req_get_sockfd(const Request *req);
 */
 int req_parse(Request *req);
 
+/**
+ * @brief Parses as much of the request as is available from the socket, without blocking
+ *
+ * Reads with MSG_DONTWAIT until the socket has no more data, and parses what was read.
+ * If the request is incomplete, call this again when the socket is readable,
+ * parsing continues from where it stopped.
+ *
+ * @param req The Request structure to parse into
+ * @return PARSE_DONE, PARSE_INVALID, or PARSE_AGAIN if more data is needed
+*/
+ParseStatus req_parse_nb(Request *req);
+
+/**
+ * @brief Feeds data from any source to the request parser
+ *
+ * The data is copied into the request's input buffer and parsed incrementally, growing the buffer
+ * as needed up to the limit on the request line and headers (req_set_max_size). Once they are
+ * parsed, only as much of the body is kept as fits in the buffer with them (see req_get_body_size),
+ * the rest of the data is dropped. So this is meant for the request line and headers.
+ *
+ * @param req The Request structure to parse into
+ * @param data The data to feed
+ * @param n The number of bytes in data
+ * @return PARSE_DONE, PARSE_INVALID, or PARSE_AGAIN if more data is needed
+*/
+ParseStatus req_feed(Request *req, const char *data, const size_t n);
+
+/**
+ * @brief Returns where the next bytes of the request should be written, to read without a copy
+ *
+ * Write at most *space bytes there (e.g. with recv or an io_uring read),
+ * then call req_parse_commit with the number of bytes written.
+ * The input buffer starts small and grows (moving it) while the headers need more room, so a
+ * pointer returned here is only valid until the next call.
+ *
+ * @param req The Request structure to read into
+ * @param space Set to the number of bytes available
+ * @return The position in the input buffer to write to
+*/
+char *req_read_buf(Request *req, bufsize_t *space);
+
+/**
+ * @brief Parses n bytes that were written at req_read_buf
+ *
+ * @param req The Request structure to parse into
+ * @param n The number of bytes written
+ * @return PARSE_DONE, PARSE_INVALID, or PARSE_AGAIN if more data is needed
+*/
+ParseStatus req_parse_commit(Request *req, const bufsize_t n);
+
 /**
  * @brief Returns the method of the request
  *
@@ -94,7 +242,7 @@ Method req_get_method(const Request *req);
  * @brief Returns the URI of the request
  *
  * @param req The Request structure to get the URI from
- * @return The URI of the request
+ * @return The URI of the request, a null-terminated view into the request. NULL if not parsed yet.
 */
 char *req_get_uri(const Request *req);
 
@@ -126,9 +274,27 @@ int req_get_num_headers(const Request *req);
  * @brief Returns the headers of the request
  *
  * @param req The Request structure to get the headers from
- * @return The headers of the request
+ * @return The headers of the request, an array of req_get_num_headers(req) elements
+*/
+const Header *req_get_headers(const Request *req);
+
+/**
+ * @brief Returns the key of a header in the request
+ *
+ * @param req The Request structure the header belongs to
+ * @param header The header to get the key of
+ * @return The key of the header. This string is null-terminated.
 */
-Header *req_get_headers(const Request *req);
+char *req_get_header_key(const Request *req, const Header *header);
+
+/**
+ * @brief Returns the value of a header in the request
+ *
+ * @param req The Request structure the header belongs to
+ * @param header The header to get the value of
+ * @return The value of the header. This string is null-terminated.
+*/
+char *req_get_header_value_of(const Request *req, const Header *header);
 
 /**
  * @brief Returns the value of a header in the request
@@ -139,16 +305,63 @@ Header *req_get_headers(const Request *req);
 */
 char *req_get_header_value(const Request *req, const char *key);
 
+/**
+ * @brief Returns the value of a well-known header in the request, without searching
+ *
+ * @param req The Request structure to get the header value from
+ * @param header The header to get the value of
+ * @return The value of the first such header in the request. NULL if it does not exist.
+*/
+char *req_get_known_header(const Request *req, const KnownHeader header);
+
 /**
  * @brief Returns the Content-Length of the request
  *
  * @param req The Request structure to get the Content-Length from
- * @return The Content-Length of the request.
+ * @return The Content-Length of the request, parsed once while parsing the headers.
  * -1 if the request does not have a Content-Length header.
  * -2 if the Content-Length header is invalid (not a number or negative).
 */
 ssize_t req_get_content_length(const Request *req);
 
+/**
+ * @brief Returns whether the client lets the connection stay open after this request
+ *
+ * HTTP/1.1 connections are persistent unless the Connection header has the close option.
+ *
+ * @param req The Request structure to check
+ * @return false if the connection should be closed after the response
+*/
+bool req_keep_alive(const Request *req);
+
+// the most ranges req_get_ranges takes, a Range header asking for more is ignored
+#define REQ_MAX_RANGES 8
+
+/**
+ * @struct ByteRange
+ * @brief One range of a Range header, as the request wrote it
+ *
+ * Bytes first to last (inclusive), or if last is -1, from first to the end, or if first is -1,
+ * the last `last` bytes.
+*/
+typedef struct {
+    long long first;
+    long long last;
+} ByteRange;
+
+/**
+ * @brief Parses the Range header of the request
+ *
+ * Only byte ranges are understood, and the ranges are not checked against any file size.
+ *
+ * @param req The Request structure to get the ranges from
+ * @param ranges Set to the ranges, in the order of the header
+ * @param max The size of ranges
+ * @return The number of ranges. 0 if the request has no Range header, or one that should be
+ * ignored: invalid, not in bytes, or with more than max ranges.
+*/
+int req_get_ranges(const Request *req, ByteRange *ranges, const int max);
+
 /**
  * @brief Returns the body of the request
  *
@@ -171,22 +384,3 @@ typedef struct response {
     // The status code of the response
     int status;
 } Response;
-
-/**
- * Initializes regex for parsing HTTP requests
- *
- * This should be called once at the beginning of your program before any other functions in this module are called
- *
- * Returns 0 if successful, -1 if failed
-*/
-int seb_http_regex_init();
-
-/**
- * Cleans up regex for parsing HTTP requests
- *
- * This should be called once at the end of your program to free memory claimed by seb_http_regex_init
- *
- * You should not call this function if seb_http_regex_init has not been called
- * or the call to seb_http_regex_init failed (returned -1)
-*/
-void seb_http_regex_cleanup();
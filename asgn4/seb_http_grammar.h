@@ -0,0 +1,78 @@
+/**
+ * @file seb_http_grammar.h
+ *
+ * The HTTP request grammar accepted by seb_http, written as POSIX extended regular expressions.
+ *
+ * These patterns are not compiled at runtime. gen_http_tables compiles _REQUEST_PATTERN into a DFA
+ * at build time and emits the transition tables into seb_http_tables.h, which seb_http.c walks.
+ *
+ * @author Sebastian Law
+*/
+
+#pragma once
+
+/*
+A valid Method contains at most eight (8) characters from the character range [a-zA-Z]. Your server
+only needs to implement (i.e., perform the semantics) of GET and PUT.
+*/
+#define _METHOD_PATTERN "([a-zA-Z]{1,8}) "
+
+/*
+A valid URI starts with the character ‘/’, includes at least 2 characters and at most 64 characters
+(including the ‘/’), and except for the leading ‘/’, only includes characters from the character set [a-zA-Z0-9.-]
+(this character set includes 64 total valid characters)
+*/
+#define _URI_PATTERN "/([a-zA-Z0-9\\.-]{1,63}) "
+
+/*
+A valid Version has the format HTTP/#.#, where each # is a single digit number. Your httpserver
+should only implement version 1.1, so it should only perform the semantics of GET and PUT requests
+that include a version equal to HTTP/1.1.
+*/
+#define _HTTP_VERSION_PATTERN "HTTP/([0-9])\\.([0-9])\r\n"
+
+/*
+Valid requests include zero (0) or more header-fields after request-line.
+A header-field is a key-value pair with the format:
+
+key: value\r\n
+
+• The key ends with the first instance of a ‘:’ character. A valid request’s header-field keys will be at least
+1 character, at most 128 characters, and only contain characters from the character set [a-zA-Z0-9.-].
+
+• A valid request’s header-field values will contain at most 128 characters and only contain characters
+from the set of printable ASCII characters (i.e., a valid value will not contain any ASCII “Device
+Control” characters nor any other binary data).
+
+• Valid requests separate each header-field using the sequence \r\n, and will terminate the list
+of header-fields with a blank header terminating in \r\n. (Essentially, regardless of how many
+header-fields a request contains, the list will terminate with the sequence \r\n\r\n).
+*/
+
+// printable ascii characters are in the range [ -~] (32-126, inclusive, ASCII space to tilde)
+
+// Pattern that matches a single header
+#define _HEADER_PATTERN "([a-zA-Z0-9\\.-]{1,128}): ([ -~]{1,128})\r\n"
+
+#define _HEADERS_PATTERN "(" _HEADER_PATTERN ")*\r\n"
+
+// The whole request line and header section
+#define _REQUEST_PATTERN _METHOD_PATTERN _URI_PATTERN _HTTP_VERSION_PATTERN _HEADERS_PATTERN
+
+/**
+ * @enum ReqTag
+ * @brief Identifies which part of the request a byte belongs to
+ *
+ * Every byte consumed by the DFA is tagged with the innermost capture group of _REQUEST_PATTERN
+ * that it matched, so these must stay in the same order as the groups in the pattern.
+*/
+typedef enum {
+    TAG_NONE,
+    TAG_METHOD,
+    TAG_URI,
+    TAG_VER_MAJOR,
+    TAG_VER_MINOR,
+    TAG_HEADER,
+    TAG_KEY,
+    TAG_VALUE,
+} ReqTag;
@@ -0,0 +1,497 @@
+/**
+ * @file seb_http_tables.h
+ *
+ * Generated by gen_http_tables from _REQUEST_PATTERN in seb_http_grammar.h, do not edit.
+*/
+
+#pragma once
+
+#define _DFA_NUM_STATES  348
+#define _DFA_NUM_CLASSES 14
+#define _DFA_DEAD        0
+#define _DFA_START       1
+
+// byte -> equivalence class
+static const unsigned char _dfa_class[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 2, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 5, 6, 7,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 9, 4, 4, 4, 4, 4,
+    4, 10, 10, 10, 10, 10, 10, 10, 11, 10, 10, 10, 10, 10, 10, 10,
+    12, 10, 10, 10, 13, 10, 10, 10, 10, 10, 10, 4, 5, 4, 4, 4,
+    4, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+    10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 4, 4, 4, 4, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+// state x class -> state
+static const unsigned short _dfa_next[_DFA_NUM_STATES][_DFA_NUM_CLASSES] = {
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2},
+    {0, 0, 0, 10, 0, 0, 0, 0, 0, 0, 3, 3, 3, 3},
+    {0, 0, 0, 10, 0, 0, 0, 0, 0, 0, 4, 4, 4, 4},
+    {0, 0, 0, 10, 0, 0, 0, 0, 0, 0, 5, 5, 5, 5},
+    {0, 0, 0, 10, 0, 0, 0, 0, 0, 0, 6, 6, 6, 6},
+    {0, 0, 0, 10, 0, 0, 0, 0, 0, 0, 7, 7, 7, 7},
+    {0, 0, 0, 10, 0, 0, 0, 0, 0, 0, 8, 8, 8, 8},
+    {0, 0, 0, 10, 0, 0, 0, 0, 0, 0, 9, 9, 9, 9},
+    {0, 0, 0, 10, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 11, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 12, 12, 0, 12, 0, 12, 12, 12, 12},
+    {0, 0, 0, 75, 0, 13, 13, 0, 13, 0, 13, 13, 13, 13},
+    {0, 0, 0, 75, 0, 14, 14, 0, 14, 0, 14, 14, 14, 14},
+    {0, 0, 0, 75, 0, 15, 15, 0, 15, 0, 15, 15, 15, 15},
+    {0, 0, 0, 75, 0, 16, 16, 0, 16, 0, 16, 16, 16, 16},
+    {0, 0, 0, 75, 0, 17, 17, 0, 17, 0, 17, 17, 17, 17},
+    {0, 0, 0, 75, 0, 18, 18, 0, 18, 0, 18, 18, 18, 18},
+    {0, 0, 0, 75, 0, 19, 19, 0, 19, 0, 19, 19, 19, 19},
+    {0, 0, 0, 75, 0, 20, 20, 0, 20, 0, 20, 20, 20, 20},
+    {0, 0, 0, 75, 0, 21, 21, 0, 21, 0, 21, 21, 21, 21},
+    {0, 0, 0, 75, 0, 22, 22, 0, 22, 0, 22, 22, 22, 22},
+    {0, 0, 0, 75, 0, 23, 23, 0, 23, 0, 23, 23, 23, 23},
+    {0, 0, 0, 75, 0, 24, 24, 0, 24, 0, 24, 24, 24, 24},
+    {0, 0, 0, 75, 0, 25, 25, 0, 25, 0, 25, 25, 25, 25},
+    {0, 0, 0, 75, 0, 26, 26, 0, 26, 0, 26, 26, 26, 26},
+    {0, 0, 0, 75, 0, 27, 27, 0, 27, 0, 27, 27, 27, 27},
+    {0, 0, 0, 75, 0, 28, 28, 0, 28, 0, 28, 28, 28, 28},
+    {0, 0, 0, 75, 0, 29, 29, 0, 29, 0, 29, 29, 29, 29},
+    {0, 0, 0, 75, 0, 30, 30, 0, 30, 0, 30, 30, 30, 30},
+    {0, 0, 0, 75, 0, 31, 31, 0, 31, 0, 31, 31, 31, 31},
+    {0, 0, 0, 75, 0, 32, 32, 0, 32, 0, 32, 32, 32, 32},
+    {0, 0, 0, 75, 0, 33, 33, 0, 33, 0, 33, 33, 33, 33},
+    {0, 0, 0, 75, 0, 34, 34, 0, 34, 0, 34, 34, 34, 34},
+    {0, 0, 0, 75, 0, 35, 35, 0, 35, 0, 35, 35, 35, 35},
+    {0, 0, 0, 75, 0, 36, 36, 0, 36, 0, 36, 36, 36, 36},
+    {0, 0, 0, 75, 0, 37, 37, 0, 37, 0, 37, 37, 37, 37},
+    {0, 0, 0, 75, 0, 38, 38, 0, 38, 0, 38, 38, 38, 38},
+    {0, 0, 0, 75, 0, 39, 39, 0, 39, 0, 39, 39, 39, 39},
+    {0, 0, 0, 75, 0, 40, 40, 0, 40, 0, 40, 40, 40, 40},
+    {0, 0, 0, 75, 0, 41, 41, 0, 41, 0, 41, 41, 41, 41},
+    {0, 0, 0, 75, 0, 42, 42, 0, 42, 0, 42, 42, 42, 42},
+    {0, 0, 0, 75, 0, 43, 43, 0, 43, 0, 43, 43, 43, 43},
+    {0, 0, 0, 75, 0, 44, 44, 0, 44, 0, 44, 44, 44, 44},
+    {0, 0, 0, 75, 0, 45, 45, 0, 45, 0, 45, 45, 45, 45},
+    {0, 0, 0, 75, 0, 46, 46, 0, 46, 0, 46, 46, 46, 46},
+    {0, 0, 0, 75, 0, 47, 47, 0, 47, 0, 47, 47, 47, 47},
+    {0, 0, 0, 75, 0, 48, 48, 0, 48, 0, 48, 48, 48, 48},
+    {0, 0, 0, 75, 0, 49, 49, 0, 49, 0, 49, 49, 49, 49},
+    {0, 0, 0, 75, 0, 50, 50, 0, 50, 0, 50, 50, 50, 50},
+    {0, 0, 0, 75, 0, 51, 51, 0, 51, 0, 51, 51, 51, 51},
+    {0, 0, 0, 75, 0, 52, 52, 0, 52, 0, 52, 52, 52, 52},
+    {0, 0, 0, 75, 0, 53, 53, 0, 53, 0, 53, 53, 53, 53},
+    {0, 0, 0, 75, 0, 54, 54, 0, 54, 0, 54, 54, 54, 54},
+    {0, 0, 0, 75, 0, 55, 55, 0, 55, 0, 55, 55, 55, 55},
+    {0, 0, 0, 75, 0, 56, 56, 0, 56, 0, 56, 56, 56, 56},
+    {0, 0, 0, 75, 0, 57, 57, 0, 57, 0, 57, 57, 57, 57},
+    {0, 0, 0, 75, 0, 58, 58, 0, 58, 0, 58, 58, 58, 58},
+    {0, 0, 0, 75, 0, 59, 59, 0, 59, 0, 59, 59, 59, 59},
+    {0, 0, 0, 75, 0, 60, 60, 0, 60, 0, 60, 60, 60, 60},
+    {0, 0, 0, 75, 0, 61, 61, 0, 61, 0, 61, 61, 61, 61},
+    {0, 0, 0, 75, 0, 62, 62, 0, 62, 0, 62, 62, 62, 62},
+    {0, 0, 0, 75, 0, 63, 63, 0, 63, 0, 63, 63, 63, 63},
+    {0, 0, 0, 75, 0, 64, 64, 0, 64, 0, 64, 64, 64, 64},
+    {0, 0, 0, 75, 0, 65, 65, 0, 65, 0, 65, 65, 65, 65},
+    {0, 0, 0, 75, 0, 66, 66, 0, 66, 0, 66, 66, 66, 66},
+    {0, 0, 0, 75, 0, 67, 67, 0, 67, 0, 67, 67, 67, 67},
+    {0, 0, 0, 75, 0, 68, 68, 0, 68, 0, 68, 68, 68, 68},
+    {0, 0, 0, 75, 0, 69, 69, 0, 69, 0, 69, 69, 69, 69},
+    {0, 0, 0, 75, 0, 70, 70, 0, 70, 0, 70, 70, 70, 70},
+    {0, 0, 0, 75, 0, 71, 71, 0, 71, 0, 71, 71, 71, 71},
+    {0, 0, 0, 75, 0, 72, 72, 0, 72, 0, 72, 72, 72, 72},
+    {0, 0, 0, 75, 0, 73, 73, 0, 73, 0, 73, 73, 73, 73},
+    {0, 0, 0, 75, 0, 74, 74, 0, 74, 0, 74, 74, 74, 74},
+    {0, 0, 0, 75, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 76, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 77},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 78},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 79, 0},
+    {0, 0, 0, 0, 0, 0, 0, 80, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 81, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 82, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 83, 0, 0, 0, 0, 0},
+    {0, 0, 84, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 85, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 86, 0, 0, 87, 87, 0, 87, 0, 87, 87, 87, 87},
+    {0, 215, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 88, 88, 0, 88, 216, 88, 88, 88, 88},
+    {0, 0, 0, 0, 0, 89, 89, 0, 89, 216, 89, 89, 89, 89},
+    {0, 0, 0, 0, 0, 90, 90, 0, 90, 216, 90, 90, 90, 90},
+    {0, 0, 0, 0, 0, 91, 91, 0, 91, 216, 91, 91, 91, 91},
+    {0, 0, 0, 0, 0, 92, 92, 0, 92, 216, 92, 92, 92, 92},
+    {0, 0, 0, 0, 0, 93, 93, 0, 93, 216, 93, 93, 93, 93},
+    {0, 0, 0, 0, 0, 94, 94, 0, 94, 216, 94, 94, 94, 94},
+    {0, 0, 0, 0, 0, 95, 95, 0, 95, 216, 95, 95, 95, 95},
+    {0, 0, 0, 0, 0, 96, 96, 0, 96, 216, 96, 96, 96, 96},
+    {0, 0, 0, 0, 0, 97, 97, 0, 97, 216, 97, 97, 97, 97},
+    {0, 0, 0, 0, 0, 98, 98, 0, 98, 216, 98, 98, 98, 98},
+    {0, 0, 0, 0, 0, 99, 99, 0, 99, 216, 99, 99, 99, 99},
+    {0, 0, 0, 0, 0, 100, 100, 0, 100, 216, 100, 100, 100, 100},
+    {0, 0, 0, 0, 0, 101, 101, 0, 101, 216, 101, 101, 101, 101},
+    {0, 0, 0, 0, 0, 102, 102, 0, 102, 216, 102, 102, 102, 102},
+    {0, 0, 0, 0, 0, 103, 103, 0, 103, 216, 103, 103, 103, 103},
+    {0, 0, 0, 0, 0, 104, 104, 0, 104, 216, 104, 104, 104, 104},
+    {0, 0, 0, 0, 0, 105, 105, 0, 105, 216, 105, 105, 105, 105},
+    {0, 0, 0, 0, 0, 106, 106, 0, 106, 216, 106, 106, 106, 106},
+    {0, 0, 0, 0, 0, 107, 107, 0, 107, 216, 107, 107, 107, 107},
+    {0, 0, 0, 0, 0, 108, 108, 0, 108, 216, 108, 108, 108, 108},
+    {0, 0, 0, 0, 0, 109, 109, 0, 109, 216, 109, 109, 109, 109},
+    {0, 0, 0, 0, 0, 110, 110, 0, 110, 216, 110, 110, 110, 110},
+    {0, 0, 0, 0, 0, 111, 111, 0, 111, 216, 111, 111, 111, 111},
+    {0, 0, 0, 0, 0, 112, 112, 0, 112, 216, 112, 112, 112, 112},
+    {0, 0, 0, 0, 0, 113, 113, 0, 113, 216, 113, 113, 113, 113},
+    {0, 0, 0, 0, 0, 114, 114, 0, 114, 216, 114, 114, 114, 114},
+    {0, 0, 0, 0, 0, 115, 115, 0, 115, 216, 115, 115, 115, 115},
+    {0, 0, 0, 0, 0, 116, 116, 0, 116, 216, 116, 116, 116, 116},
+    {0, 0, 0, 0, 0, 117, 117, 0, 117, 216, 117, 117, 117, 117},
+    {0, 0, 0, 0, 0, 118, 118, 0, 118, 216, 118, 118, 118, 118},
+    {0, 0, 0, 0, 0, 119, 119, 0, 119, 216, 119, 119, 119, 119},
+    {0, 0, 0, 0, 0, 120, 120, 0, 120, 216, 120, 120, 120, 120},
+    {0, 0, 0, 0, 0, 121, 121, 0, 121, 216, 121, 121, 121, 121},
+    {0, 0, 0, 0, 0, 122, 122, 0, 122, 216, 122, 122, 122, 122},
+    {0, 0, 0, 0, 0, 123, 123, 0, 123, 216, 123, 123, 123, 123},
+    {0, 0, 0, 0, 0, 124, 124, 0, 124, 216, 124, 124, 124, 124},
+    {0, 0, 0, 0, 0, 125, 125, 0, 125, 216, 125, 125, 125, 125},
+    {0, 0, 0, 0, 0, 126, 126, 0, 126, 216, 126, 126, 126, 126},
+    {0, 0, 0, 0, 0, 127, 127, 0, 127, 216, 127, 127, 127, 127},
+    {0, 0, 0, 0, 0, 128, 128, 0, 128, 216, 128, 128, 128, 128},
+    {0, 0, 0, 0, 0, 129, 129, 0, 129, 216, 129, 129, 129, 129},
+    {0, 0, 0, 0, 0, 130, 130, 0, 130, 216, 130, 130, 130, 130},
+    {0, 0, 0, 0, 0, 131, 131, 0, 131, 216, 131, 131, 131, 131},
+    {0, 0, 0, 0, 0, 132, 132, 0, 132, 216, 132, 132, 132, 132},
+    {0, 0, 0, 0, 0, 133, 133, 0, 133, 216, 133, 133, 133, 133},
+    {0, 0, 0, 0, 0, 134, 134, 0, 134, 216, 134, 134, 134, 134},
+    {0, 0, 0, 0, 0, 135, 135, 0, 135, 216, 135, 135, 135, 135},
+    {0, 0, 0, 0, 0, 136, 136, 0, 136, 216, 136, 136, 136, 136},
+    {0, 0, 0, 0, 0, 137, 137, 0, 137, 216, 137, 137, 137, 137},
+    {0, 0, 0, 0, 0, 138, 138, 0, 138, 216, 138, 138, 138, 138},
+    {0, 0, 0, 0, 0, 139, 139, 0, 139, 216, 139, 139, 139, 139},
+    {0, 0, 0, 0, 0, 140, 140, 0, 140, 216, 140, 140, 140, 140},
+    {0, 0, 0, 0, 0, 141, 141, 0, 141, 216, 141, 141, 141, 141},
+    {0, 0, 0, 0, 0, 142, 142, 0, 142, 216, 142, 142, 142, 142},
+    {0, 0, 0, 0, 0, 143, 143, 0, 143, 216, 143, 143, 143, 143},
+    {0, 0, 0, 0, 0, 144, 144, 0, 144, 216, 144, 144, 144, 144},
+    {0, 0, 0, 0, 0, 145, 145, 0, 145, 216, 145, 145, 145, 145},
+    {0, 0, 0, 0, 0, 146, 146, 0, 146, 216, 146, 146, 146, 146},
+    {0, 0, 0, 0, 0, 147, 147, 0, 147, 216, 147, 147, 147, 147},
+    {0, 0, 0, 0, 0, 148, 148, 0, 148, 216, 148, 148, 148, 148},
+    {0, 0, 0, 0, 0, 149, 149, 0, 149, 216, 149, 149, 149, 149},
+    {0, 0, 0, 0, 0, 150, 150, 0, 150, 216, 150, 150, 150, 150},
+    {0, 0, 0, 0, 0, 151, 151, 0, 151, 216, 151, 151, 151, 151},
+    {0, 0, 0, 0, 0, 152, 152, 0, 152, 216, 152, 152, 152, 152},
+    {0, 0, 0, 0, 0, 153, 153, 0, 153, 216, 153, 153, 153, 153},
+    {0, 0, 0, 0, 0, 154, 154, 0, 154, 216, 154, 154, 154, 154},
+    {0, 0, 0, 0, 0, 155, 155, 0, 155, 216, 155, 155, 155, 155},
+    {0, 0, 0, 0, 0, 156, 156, 0, 156, 216, 156, 156, 156, 156},
+    {0, 0, 0, 0, 0, 157, 157, 0, 157, 216, 157, 157, 157, 157},
+    {0, 0, 0, 0, 0, 158, 158, 0, 158, 216, 158, 158, 158, 158},
+    {0, 0, 0, 0, 0, 159, 159, 0, 159, 216, 159, 159, 159, 159},
+    {0, 0, 0, 0, 0, 160, 160, 0, 160, 216, 160, 160, 160, 160},
+    {0, 0, 0, 0, 0, 161, 161, 0, 161, 216, 161, 161, 161, 161},
+    {0, 0, 0, 0, 0, 162, 162, 0, 162, 216, 162, 162, 162, 162},
+    {0, 0, 0, 0, 0, 163, 163, 0, 163, 216, 163, 163, 163, 163},
+    {0, 0, 0, 0, 0, 164, 164, 0, 164, 216, 164, 164, 164, 164},
+    {0, 0, 0, 0, 0, 165, 165, 0, 165, 216, 165, 165, 165, 165},
+    {0, 0, 0, 0, 0, 166, 166, 0, 166, 216, 166, 166, 166, 166},
+    {0, 0, 0, 0, 0, 167, 167, 0, 167, 216, 167, 167, 167, 167},
+    {0, 0, 0, 0, 0, 168, 168, 0, 168, 216, 168, 168, 168, 168},
+    {0, 0, 0, 0, 0, 169, 169, 0, 169, 216, 169, 169, 169, 169},
+    {0, 0, 0, 0, 0, 170, 170, 0, 170, 216, 170, 170, 170, 170},
+    {0, 0, 0, 0, 0, 171, 171, 0, 171, 216, 171, 171, 171, 171},
+    {0, 0, 0, 0, 0, 172, 172, 0, 172, 216, 172, 172, 172, 172},
+    {0, 0, 0, 0, 0, 173, 173, 0, 173, 216, 173, 173, 173, 173},
+    {0, 0, 0, 0, 0, 174, 174, 0, 174, 216, 174, 174, 174, 174},
+    {0, 0, 0, 0, 0, 175, 175, 0, 175, 216, 175, 175, 175, 175},
+    {0, 0, 0, 0, 0, 176, 176, 0, 176, 216, 176, 176, 176, 176},
+    {0, 0, 0, 0, 0, 177, 177, 0, 177, 216, 177, 177, 177, 177},
+    {0, 0, 0, 0, 0, 178, 178, 0, 178, 216, 178, 178, 178, 178},
+    {0, 0, 0, 0, 0, 179, 179, 0, 179, 216, 179, 179, 179, 179},
+    {0, 0, 0, 0, 0, 180, 180, 0, 180, 216, 180, 180, 180, 180},
+    {0, 0, 0, 0, 0, 181, 181, 0, 181, 216, 181, 181, 181, 181},
+    {0, 0, 0, 0, 0, 182, 182, 0, 182, 216, 182, 182, 182, 182},
+    {0, 0, 0, 0, 0, 183, 183, 0, 183, 216, 183, 183, 183, 183},
+    {0, 0, 0, 0, 0, 184, 184, 0, 184, 216, 184, 184, 184, 184},
+    {0, 0, 0, 0, 0, 185, 185, 0, 185, 216, 185, 185, 185, 185},
+    {0, 0, 0, 0, 0, 186, 186, 0, 186, 216, 186, 186, 186, 186},
+    {0, 0, 0, 0, 0, 187, 187, 0, 187, 216, 187, 187, 187, 187},
+    {0, 0, 0, 0, 0, 188, 188, 0, 188, 216, 188, 188, 188, 188},
+    {0, 0, 0, 0, 0, 189, 189, 0, 189, 216, 189, 189, 189, 189},
+    {0, 0, 0, 0, 0, 190, 190, 0, 190, 216, 190, 190, 190, 190},
+    {0, 0, 0, 0, 0, 191, 191, 0, 191, 216, 191, 191, 191, 191},
+    {0, 0, 0, 0, 0, 192, 192, 0, 192, 216, 192, 192, 192, 192},
+    {0, 0, 0, 0, 0, 193, 193, 0, 193, 216, 193, 193, 193, 193},
+    {0, 0, 0, 0, 0, 194, 194, 0, 194, 216, 194, 194, 194, 194},
+    {0, 0, 0, 0, 0, 195, 195, 0, 195, 216, 195, 195, 195, 195},
+    {0, 0, 0, 0, 0, 196, 196, 0, 196, 216, 196, 196, 196, 196},
+    {0, 0, 0, 0, 0, 197, 197, 0, 197, 216, 197, 197, 197, 197},
+    {0, 0, 0, 0, 0, 198, 198, 0, 198, 216, 198, 198, 198, 198},
+    {0, 0, 0, 0, 0, 199, 199, 0, 199, 216, 199, 199, 199, 199},
+    {0, 0, 0, 0, 0, 200, 200, 0, 200, 216, 200, 200, 200, 200},
+    {0, 0, 0, 0, 0, 201, 201, 0, 201, 216, 201, 201, 201, 201},
+    {0, 0, 0, 0, 0, 202, 202, 0, 202, 216, 202, 202, 202, 202},
+    {0, 0, 0, 0, 0, 203, 203, 0, 203, 216, 203, 203, 203, 203},
+    {0, 0, 0, 0, 0, 204, 204, 0, 204, 216, 204, 204, 204, 204},
+    {0, 0, 0, 0, 0, 205, 205, 0, 205, 216, 205, 205, 205, 205},
+    {0, 0, 0, 0, 0, 206, 206, 0, 206, 216, 206, 206, 206, 206},
+    {0, 0, 0, 0, 0, 207, 207, 0, 207, 216, 207, 207, 207, 207},
+    {0, 0, 0, 0, 0, 208, 208, 0, 208, 216, 208, 208, 208, 208},
+    {0, 0, 0, 0, 0, 209, 209, 0, 209, 216, 209, 209, 209, 209},
+    {0, 0, 0, 0, 0, 210, 210, 0, 210, 216, 210, 210, 210, 210},
+    {0, 0, 0, 0, 0, 211, 211, 0, 211, 216, 211, 211, 211, 211},
+    {0, 0, 0, 0, 0, 212, 212, 0, 212, 216, 212, 212, 212, 212},
+    {0, 0, 0, 0, 0, 213, 213, 0, 213, 216, 213, 213, 213, 213},
+    {0, 0, 0, 0, 0, 214, 214, 0, 214, 216, 214, 214, 214, 214},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 216, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 217, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 218, 218, 218, 218, 218, 218, 218, 218, 218, 218, 218},
+    {0, 0, 346, 219, 219, 219, 219, 219, 219, 219, 219, 219, 219, 219},
+    {0, 0, 346, 220, 220, 220, 220, 220, 220, 220, 220, 220, 220, 220},
+    {0, 0, 346, 221, 221, 221, 221, 221, 221, 221, 221, 221, 221, 221},
+    {0, 0, 346, 222, 222, 222, 222, 222, 222, 222, 222, 222, 222, 222},
+    {0, 0, 346, 223, 223, 223, 223, 223, 223, 223, 223, 223, 223, 223},
+    {0, 0, 346, 224, 224, 224, 224, 224, 224, 224, 224, 224, 224, 224},
+    {0, 0, 346, 225, 225, 225, 225, 225, 225, 225, 225, 225, 225, 225},
+    {0, 0, 346, 226, 226, 226, 226, 226, 226, 226, 226, 226, 226, 226},
+    {0, 0, 346, 227, 227, 227, 227, 227, 227, 227, 227, 227, 227, 227},
+    {0, 0, 346, 228, 228, 228, 228, 228, 228, 228, 228, 228, 228, 228},
+    {0, 0, 346, 229, 229, 229, 229, 229, 229, 229, 229, 229, 229, 229},
+    {0, 0, 346, 230, 230, 230, 230, 230, 230, 230, 230, 230, 230, 230},
+    {0, 0, 346, 231, 231, 231, 231, 231, 231, 231, 231, 231, 231, 231},
+    {0, 0, 346, 232, 232, 232, 232, 232, 232, 232, 232, 232, 232, 232},
+    {0, 0, 346, 233, 233, 233, 233, 233, 233, 233, 233, 233, 233, 233},
+    {0, 0, 346, 234, 234, 234, 234, 234, 234, 234, 234, 234, 234, 234},
+    {0, 0, 346, 235, 235, 235, 235, 235, 235, 235, 235, 235, 235, 235},
+    {0, 0, 346, 236, 236, 236, 236, 236, 236, 236, 236, 236, 236, 236},
+    {0, 0, 346, 237, 237, 237, 237, 237, 237, 237, 237, 237, 237, 237},
+    {0, 0, 346, 238, 238, 238, 238, 238, 238, 238, 238, 238, 238, 238},
+    {0, 0, 346, 239, 239, 239, 239, 239, 239, 239, 239, 239, 239, 239},
+    {0, 0, 346, 240, 240, 240, 240, 240, 240, 240, 240, 240, 240, 240},
+    {0, 0, 346, 241, 241, 241, 241, 241, 241, 241, 241, 241, 241, 241},
+    {0, 0, 346, 242, 242, 242, 242, 242, 242, 242, 242, 242, 242, 242},
+    {0, 0, 346, 243, 243, 243, 243, 243, 243, 243, 243, 243, 243, 243},
+    {0, 0, 346, 244, 244, 244, 244, 244, 244, 244, 244, 244, 244, 244},
+    {0, 0, 346, 245, 245, 245, 245, 245, 245, 245, 245, 245, 245, 245},
+    {0, 0, 346, 246, 246, 246, 246, 246, 246, 246, 246, 246, 246, 246},
+    {0, 0, 346, 247, 247, 247, 247, 247, 247, 247, 247, 247, 247, 247},
+    {0, 0, 346, 248, 248, 248, 248, 248, 248, 248, 248, 248, 248, 248},
+    {0, 0, 346, 249, 249, 249, 249, 249, 249, 249, 249, 249, 249, 249},
+    {0, 0, 346, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250},
+    {0, 0, 346, 251, 251, 251, 251, 251, 251, 251, 251, 251, 251, 251},
+    {0, 0, 346, 252, 252, 252, 252, 252, 252, 252, 252, 252, 252, 252},
+    {0, 0, 346, 253, 253, 253, 253, 253, 253, 253, 253, 253, 253, 253},
+    {0, 0, 346, 254, 254, 254, 254, 254, 254, 254, 254, 254, 254, 254},
+    {0, 0, 346, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+    {0, 0, 346, 256, 256, 256, 256, 256, 256, 256, 256, 256, 256, 256},
+    {0, 0, 346, 257, 257, 257, 257, 257, 257, 257, 257, 257, 257, 257},
+    {0, 0, 346, 258, 258, 258, 258, 258, 258, 258, 258, 258, 258, 258},
+    {0, 0, 346, 259, 259, 259, 259, 259, 259, 259, 259, 259, 259, 259},
+    {0, 0, 346, 260, 260, 260, 260, 260, 260, 260, 260, 260, 260, 260},
+    {0, 0, 346, 261, 261, 261, 261, 261, 261, 261, 261, 261, 261, 261},
+    {0, 0, 346, 262, 262, 262, 262, 262, 262, 262, 262, 262, 262, 262},
+    {0, 0, 346, 263, 263, 263, 263, 263, 263, 263, 263, 263, 263, 263},
+    {0, 0, 346, 264, 264, 264, 264, 264, 264, 264, 264, 264, 264, 264},
+    {0, 0, 346, 265, 265, 265, 265, 265, 265, 265, 265, 265, 265, 265},
+    {0, 0, 346, 266, 266, 266, 266, 266, 266, 266, 266, 266, 266, 266},
+    {0, 0, 346, 267, 267, 267, 267, 267, 267, 267, 267, 267, 267, 267},
+    {0, 0, 346, 268, 268, 268, 268, 268, 268, 268, 268, 268, 268, 268},
+    {0, 0, 346, 269, 269, 269, 269, 269, 269, 269, 269, 269, 269, 269},
+    {0, 0, 346, 270, 270, 270, 270, 270, 270, 270, 270, 270, 270, 270},
+    {0, 0, 346, 271, 271, 271, 271, 271, 271, 271, 271, 271, 271, 271},
+    {0, 0, 346, 272, 272, 272, 272, 272, 272, 272, 272, 272, 272, 272},
+    {0, 0, 346, 273, 273, 273, 273, 273, 273, 273, 273, 273, 273, 273},
+    {0, 0, 346, 274, 274, 274, 274, 274, 274, 274, 274, 274, 274, 274},
+    {0, 0, 346, 275, 275, 275, 275, 275, 275, 275, 275, 275, 275, 275},
+    {0, 0, 346, 276, 276, 276, 276, 276, 276, 276, 276, 276, 276, 276},
+    {0, 0, 346, 277, 277, 277, 277, 277, 277, 277, 277, 277, 277, 277},
+    {0, 0, 346, 278, 278, 278, 278, 278, 278, 278, 278, 278, 278, 278},
+    {0, 0, 346, 279, 279, 279, 279, 279, 279, 279, 279, 279, 279, 279},
+    {0, 0, 346, 280, 280, 280, 280, 280, 280, 280, 280, 280, 280, 280},
+    {0, 0, 346, 281, 281, 281, 281, 281, 281, 281, 281, 281, 281, 281},
+    {0, 0, 346, 282, 282, 282, 282, 282, 282, 282, 282, 282, 282, 282},
+    {0, 0, 346, 283, 283, 283, 283, 283, 283, 283, 283, 283, 283, 283},
+    {0, 0, 346, 284, 284, 284, 284, 284, 284, 284, 284, 284, 284, 284},
+    {0, 0, 346, 285, 285, 285, 285, 285, 285, 285, 285, 285, 285, 285},
+    {0, 0, 346, 286, 286, 286, 286, 286, 286, 286, 286, 286, 286, 286},
+    {0, 0, 346, 287, 287, 287, 287, 287, 287, 287, 287, 287, 287, 287},
+    {0, 0, 346, 288, 288, 288, 288, 288, 288, 288, 288, 288, 288, 288},
+    {0, 0, 346, 289, 289, 289, 289, 289, 289, 289, 289, 289, 289, 289},
+    {0, 0, 346, 290, 290, 290, 290, 290, 290, 290, 290, 290, 290, 290},
+    {0, 0, 346, 291, 291, 291, 291, 291, 291, 291, 291, 291, 291, 291},
+    {0, 0, 346, 292, 292, 292, 292, 292, 292, 292, 292, 292, 292, 292},
+    {0, 0, 346, 293, 293, 293, 293, 293, 293, 293, 293, 293, 293, 293},
+    {0, 0, 346, 294, 294, 294, 294, 294, 294, 294, 294, 294, 294, 294},
+    {0, 0, 346, 295, 295, 295, 295, 295, 295, 295, 295, 295, 295, 295},
+    {0, 0, 346, 296, 296, 296, 296, 296, 296, 296, 296, 296, 296, 296},
+    {0, 0, 346, 297, 297, 297, 297, 297, 297, 297, 297, 297, 297, 297},
+    {0, 0, 346, 298, 298, 298, 298, 298, 298, 298, 298, 298, 298, 298},
+    {0, 0, 346, 299, 299, 299, 299, 299, 299, 299, 299, 299, 299, 299},
+    {0, 0, 346, 300, 300, 300, 300, 300, 300, 300, 300, 300, 300, 300},
+    {0, 0, 346, 301, 301, 301, 301, 301, 301, 301, 301, 301, 301, 301},
+    {0, 0, 346, 302, 302, 302, 302, 302, 302, 302, 302, 302, 302, 302},
+    {0, 0, 346, 303, 303, 303, 303, 303, 303, 303, 303, 303, 303, 303},
+    {0, 0, 346, 304, 304, 304, 304, 304, 304, 304, 304, 304, 304, 304},
+    {0, 0, 346, 305, 305, 305, 305, 305, 305, 305, 305, 305, 305, 305},
+    {0, 0, 346, 306, 306, 306, 306, 306, 306, 306, 306, 306, 306, 306},
+    {0, 0, 346, 307, 307, 307, 307, 307, 307, 307, 307, 307, 307, 307},
+    {0, 0, 346, 308, 308, 308, 308, 308, 308, 308, 308, 308, 308, 308},
+    {0, 0, 346, 309, 309, 309, 309, 309, 309, 309, 309, 309, 309, 309},
+    {0, 0, 346, 310, 310, 310, 310, 310, 310, 310, 310, 310, 310, 310},
+    {0, 0, 346, 311, 311, 311, 311, 311, 311, 311, 311, 311, 311, 311},
+    {0, 0, 346, 312, 312, 312, 312, 312, 312, 312, 312, 312, 312, 312},
+    {0, 0, 346, 313, 313, 313, 313, 313, 313, 313, 313, 313, 313, 313},
+    {0, 0, 346, 314, 314, 314, 314, 314, 314, 314, 314, 314, 314, 314},
+    {0, 0, 346, 315, 315, 315, 315, 315, 315, 315, 315, 315, 315, 315},
+    {0, 0, 346, 316, 316, 316, 316, 316, 316, 316, 316, 316, 316, 316},
+    {0, 0, 346, 317, 317, 317, 317, 317, 317, 317, 317, 317, 317, 317},
+    {0, 0, 346, 318, 318, 318, 318, 318, 318, 318, 318, 318, 318, 318},
+    {0, 0, 346, 319, 319, 319, 319, 319, 319, 319, 319, 319, 319, 319},
+    {0, 0, 346, 320, 320, 320, 320, 320, 320, 320, 320, 320, 320, 320},
+    {0, 0, 346, 321, 321, 321, 321, 321, 321, 321, 321, 321, 321, 321},
+    {0, 0, 346, 322, 322, 322, 322, 322, 322, 322, 322, 322, 322, 322},
+    {0, 0, 346, 323, 323, 323, 323, 323, 323, 323, 323, 323, 323, 323},
+    {0, 0, 346, 324, 324, 324, 324, 324, 324, 324, 324, 324, 324, 324},
+    {0, 0, 346, 325, 325, 325, 325, 325, 325, 325, 325, 325, 325, 325},
+    {0, 0, 346, 326, 326, 326, 326, 326, 326, 326, 326, 326, 326, 326},
+    {0, 0, 346, 327, 327, 327, 327, 327, 327, 327, 327, 327, 327, 327},
+    {0, 0, 346, 328, 328, 328, 328, 328, 328, 328, 328, 328, 328, 328},
+    {0, 0, 346, 329, 329, 329, 329, 329, 329, 329, 329, 329, 329, 329},
+    {0, 0, 346, 330, 330, 330, 330, 330, 330, 330, 330, 330, 330, 330},
+    {0, 0, 346, 331, 331, 331, 331, 331, 331, 331, 331, 331, 331, 331},
+    {0, 0, 346, 332, 332, 332, 332, 332, 332, 332, 332, 332, 332, 332},
+    {0, 0, 346, 333, 333, 333, 333, 333, 333, 333, 333, 333, 333, 333},
+    {0, 0, 346, 334, 334, 334, 334, 334, 334, 334, 334, 334, 334, 334},
+    {0, 0, 346, 335, 335, 335, 335, 335, 335, 335, 335, 335, 335, 335},
+    {0, 0, 346, 336, 336, 336, 336, 336, 336, 336, 336, 336, 336, 336},
+    {0, 0, 346, 337, 337, 337, 337, 337, 337, 337, 337, 337, 337, 337},
+    {0, 0, 346, 338, 338, 338, 338, 338, 338, 338, 338, 338, 338, 338},
+    {0, 0, 346, 339, 339, 339, 339, 339, 339, 339, 339, 339, 339, 339},
+    {0, 0, 346, 340, 340, 340, 340, 340, 340, 340, 340, 340, 340, 340},
+    {0, 0, 346, 341, 341, 341, 341, 341, 341, 341, 341, 341, 341, 341},
+    {0, 0, 346, 342, 342, 342, 342, 342, 342, 342, 342, 342, 342, 342},
+    {0, 0, 346, 343, 343, 343, 343, 343, 343, 343, 343, 343, 343, 343},
+    {0, 0, 346, 344, 344, 344, 344, 344, 344, 344, 344, 344, 344, 344},
+    {0, 0, 346, 345, 345, 345, 345, 345, 345, 345, 345, 345, 345, 345},
+    {0, 0, 346, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 347, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 86, 0, 0, 87, 87, 0, 87, 0, 87, 87, 87, 87},
+};
+
+// the ReqTag of the byte consumed to enter each state
+static const unsigned char _dfa_tag[_DFA_NUM_STATES] = {
+    0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0,
+    0, 3, 0, 4, 0, 0, 0, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 0, 5, 5, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 5, 5,
+};
+
+// whether each state accepts
+static const unsigned char _dfa_accept[_DFA_NUM_STATES] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+// the ScanClass of the run each state is in
+static const unsigned char _dfa_run_class[_DFA_NUM_STATES] = {
+    0, 0, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 0,
+};
+
+// how many more bytes of the run can be skipped from each state
+static const unsigned char _dfa_run_len[_DFA_NUM_STATES] = {
+    0, 0, 7, 6, 5, 4, 3, 2, 1, 0, 0, 0, 62, 61, 60, 59,
+    58, 57, 56, 55, 54, 53, 52, 51, 50, 49, 48, 47, 46, 45, 44, 43,
+    42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 32, 31, 30, 29, 28, 27,
+    26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11,
+    10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 127, 126, 125, 124, 123, 122, 121, 120, 119,
+    118, 117, 116, 115, 114, 113, 112, 111, 110, 109, 108, 107, 106, 105, 104, 103,
+    102, 101, 100, 99, 98, 97, 96, 95, 94, 93, 92, 91, 90, 89, 88, 87,
+    86, 85, 84, 83, 82, 81, 80, 79, 78, 77, 76, 75, 74, 73, 72, 71,
+    70, 69, 68, 67, 66, 65, 64, 63, 62, 61, 60, 59, 58, 57, 56, 55,
+    54, 53, 52, 51, 50, 49, 48, 47, 46, 45, 44, 43, 42, 41, 40, 39,
+    38, 37, 36, 35, 34, 33, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23,
+    22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7,
+    6, 5, 4, 3, 2, 1, 0, 0, 0, 0, 127, 126, 125, 124, 123, 122,
+    121, 120, 119, 118, 117, 116, 115, 114, 113, 112, 111, 110, 109, 108, 107, 106,
+    105, 104, 103, 102, 101, 100, 99, 98, 97, 96, 95, 94, 93, 92, 91, 90,
+    89, 88, 87, 86, 85, 84, 83, 82, 81, 80, 79, 78, 77, 76, 75, 74,
+    73, 72, 71, 70, 69, 68, 67, 66, 65, 64, 63, 62, 61, 60, 59, 58,
+    57, 56, 55, 54, 53, 52, 51, 50, 49, 48, 47, 46, 45, 44, 43, 42,
+    41, 40, 39, 38, 37, 36, 35, 34, 33, 32, 31, 30, 29, 28, 27, 26,
+    25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10,
+    9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0, 0,
+};
+
+// perfect hash of the KNOWN_HEADERS names, first and last must already be OR'd with 0x20
+#define _HDR_MAX_LEN 17
+#define _HDR_HASH(len, first, last) (((len) * 2 + (first) * 15 + (last)) & 15)
+
+// hash -> KnownHeader, or -1
+static const signed char _hdr_slot[16] = {
+    -1, 0, -1, -1, 2, 8, 1, -1, -1, 5, -1, 7, -1, 4, 6, 3,
+};
@@ -0,0 +1,533 @@
+// splice, pipe2, F_SETPIPE_SZ, sync_file_range and fallocate are Linux extensions
+#define _GNU_SOURCE
+
+#include "seb_io.h"
+
+#include "asgn2_helper_funcs.h"
+
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// sendfile moves at most this much per call (see sendfile(2)), ask for no more than that
+#define _SENDFILE_MAX 0x7ffff000
+
+// IO_DROP_CACHE writes back and drops uploads in windows of this size
+#define _DROP_WINDOW (8 << 20)
+
+// how large we ask the kernel to make splice pipes, limited by /proc/sys/fs/pipe-max-size
+#define _PIPE_SIZE (1 << 20)
+
+// IO_PIPELINE copies through two buffers of this size, aligned to disk blocks
+#define _COPY_BUF_SIZE (1 << 20)
+#define _COPY_ALIGN    4096
+
+// the pipe used for splicing, one per thread so workers never share one
+typedef struct {
+    int rd, wr;
+    // the capacity of the pipe, also the most we splice in one go
+    size_t size;
+} SplicePipe;
+
+static __thread SplicePipe _pipe = {-1, -1, 0};
+
+// returns the calling thread's pipe, creating it on first use, or NULL if no pipe can be made
+static SplicePipe *pipe_get(void) {
+    if (_pipe.rd != -1) {
+        return &_pipe;
+    }
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) == -1) {
+        return NULL;
+    }
+
+    // if the kernel refuses the larger size, we just work with the default one
+    fcntl(fds[1], F_SETPIPE_SZ, _PIPE_SIZE);
+    const int size = fcntl(fds[1], F_GETPIPE_SZ);
+
+    _pipe.rd = fds[0];
+    _pipe.wr = fds[1];
+    _pipe.size = size > 0 ? (size_t) size : 4096;
+    return &_pipe;
+}
+
+// throws the pipe away, for when it is left holding data we can't get rid of
+static void pipe_discard(SplicePipe *p) {
+    close(p->rd);
+    close(p->wr);
+    p->rd = p->wr = -1;
+}
+
+// copies n bytes waiting in the pipe into the file through userspace, returns -1 on error
+static int pipe_copy_out(SplicePipe *p, const int fd, size_t n) {
+    char buf[4096];
+
+    while (n > 0) {
+        const ssize_t rb = read(p->rd, buf, n < sizeof(buf) ? n : sizeof(buf));
+        if (rb <= 0 || write_n_bytes(fd, buf, rb) != rb) {
+            return -1;
+        }
+        n -= rb;
+    }
+
+    return 0;
+}
+
+// for IO_DROP_CACHE: where in the file the transfer started, and how much of what was written
+// has been handed to writeback, and has been dropped from the page cache
+typedef struct {
+    off_t base;
+    size_t written_back;
+    size_t dropped;
+} DropWindow;
+
+static void drop_window_init(DropWindow *dw, const int fd) {
+    dw->base = lseek(fd, 0, SEEK_CUR);
+    dw->written_back = dw->dropped = 0;
+}
+
+// called as the transfer goes, with how many bytes of it are in the file so far
+static void drop_window_advance(DropWindow *dw, const int fd, const size_t moved) {
+    if (dw->base == -1 || moved - dw->written_back < _DROP_WINDOW) {
+        return;
+    }
+
+    // start writing back the window that just arrived, without waiting for it
+    sync_file_range(fd, dw->base + dw->written_back, moved - dw->written_back,
+        SYNC_FILE_RANGE_WRITE);
+
+    // the window before it has had a whole window's time to get to disk,
+    // wait for the rest of it and drop it from the page cache
+    if (dw->written_back > dw->dropped) {
+        sync_file_range(fd, dw->base + dw->dropped, dw->written_back - dw->dropped,
+            SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise(
+            fd, dw->base + dw->dropped, dw->written_back - dw->dropped, POSIX_FADV_DONTNEED);
+        dw->dropped = dw->written_back;
+    }
+    dw->written_back = moved;
+}
+
+// the IO_PIPELINE copy engine
+//
+// Each calling thread gets a helper thread and two large buffers. The caller receives the body
+// into one buffer while the helper writes the other to the file, then they swap, so the socket
+// and the disk are busy at the same time instead of taking turns.
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    char *buf[2];
+    // how much of each buffer is waiting to be written, 0 once the helper is done with it
+    size_t len[2];
+    // the buffer the helper writes next, where the next transfer has to start too
+    int next;
+
+    // the transfer in progress, set before its first buffer is handed over
+    int fd;
+    int flags;
+    DropWindow drop;
+    // how much the helper has written, and whether a write failed (nothing more is written then)
+    size_t written;
+    bool failed;
+} Copier;
+
+static __thread Copier *_copier = NULL;
+
+static void *copier_loop(void *arg) {
+    Copier *cp = arg;
+
+    pthread_mutex_lock(&cp->mutex);
+    while (true) {
+        while (cp->len[cp->next] == 0) {
+            pthread_cond_wait(&cp->cond, &cp->mutex);
+        }
+        const int i = cp->next;
+        const size_t len = cp->len[i];
+        const bool skip = cp->failed;
+        pthread_mutex_unlock(&cp->mutex);
+
+        const ssize_t wb = skip ? -1 : write_n_bytes(cp->fd, cp->buf[i], len);
+        if (wb == (ssize_t) len && (cp->flags & IO_DROP_CACHE)) {
+            // this may wait for the disk, so not under the lock (only the helper changes written)
+            drop_window_advance(&cp->drop, cp->fd, cp->written + len);
+        }
+
+        pthread_mutex_lock(&cp->mutex);
+        if (wb > 0) {
+            cp->written += wb;
+        }
+        if (wb != (ssize_t) len) {
+            cp->failed = true;
+        }
+
+        cp->len[i] = 0;
+        cp->next = i ^ 1;
+        pthread_cond_broadcast(&cp->cond);
+    }
+
+    return NULL;
+}
+
+// returns the calling thread's copier, starting its helper on first use, or NULL if it can't
+static Copier *copier_get(void) {
+    if (_copier != NULL) {
+        return _copier;
+    }
+
+    Copier *cp = calloc(1, sizeof(Copier));
+    if (cp == NULL) {
+        return NULL;
+    }
+
+    cp->buf[0] = aligned_alloc(_COPY_ALIGN, _COPY_BUF_SIZE);
+    cp->buf[1] = aligned_alloc(_COPY_ALIGN, _COPY_BUF_SIZE);
+    pthread_mutex_init(&cp->mutex, NULL);
+    pthread_cond_init(&cp->cond, NULL);
+
+    if (cp->buf[0] == NULL || cp->buf[1] == NULL
+        || pthread_create(&cp->thread, NULL, copier_loop, cp) != 0) {
+        free(cp->buf[0]);
+        free(cp->buf[1]);
+        pthread_mutex_destroy(&cp->mutex);
+        pthread_cond_destroy(&cp->cond);
+        free(cp);
+        return NULL;
+    }
+
+    // it lives as long as the calling thread, which lives as long as the server
+    pthread_detach(cp->thread);
+    _copier = cp;
+    return cp;
+}
+
+static ssize_t recv_pipelined(Copier *cp, const int sock, const int fd, const size_t n,
+    const int flags) {
+    // nothing is in flight between transfers, so the helper isn't looking at these
+    cp->fd = fd;
+    cp->flags = flags;
+    cp->written = 0;
+    cp->failed = false;
+    if (flags & IO_DROP_CACHE) {
+        drop_window_init(&cp->drop, fd);
+    }
+
+    size_t received = 0;
+    bool done = false;
+
+    // a transfer that used an odd number of buffers left the helper on the second one
+    pthread_mutex_lock(&cp->mutex);
+    const int first = cp->next;
+    pthread_mutex_unlock(&cp->mutex);
+
+    for (int i = first; !done && received < n; i ^= 1) {
+        // wait for the helper to be done writing this buffer
+        pthread_mutex_lock(&cp->mutex);
+        while (cp->len[i] != 0) {
+            pthread_cond_wait(&cp->cond, &cp->mutex);
+        }
+        done = cp->failed;
+        pthread_mutex_unlock(&cp->mutex);
+
+        // fill it, while the helper writes the other one
+        const size_t want = n - received < _COPY_BUF_SIZE ? n - received : _COPY_BUF_SIZE;
+        size_t filled = 0;
+        while (!done && filled < want) {
+            const ssize_t rb = recv(sock, cp->buf[i] + filled, want - filled, MSG_WAITALL);
+            if (rb == -1 && errno == EINTR) {
+                continue;
+            }
+            if (rb <= 0) {
+                // the client closed the connection before sending the whole body, or an error
+                done = true;
+                break;
+            }
+            filled += rb;
+        }
+
+        if (filled > 0) {
+            received += filled;
+
+            pthread_mutex_lock(&cp->mutex);
+            cp->len[i] = filled;
+            pthread_cond_broadcast(&cp->cond);
+            pthread_mutex_unlock(&cp->mutex);
+        }
+    }
+
+    // wait for the helper to write what's left
+    pthread_mutex_lock(&cp->mutex);
+    while (cp->len[0] != 0 || cp->len[1] != 0) {
+        pthread_cond_wait(&cp->cond, &cp->mutex);
+    }
+    const size_t written = cp->written;
+    const bool failed = cp->failed;
+    pthread_mutex_unlock(&cp->mutex);
+
+    // a file missing part of the body is no use, however much of it made it
+    return failed ? -1 : (ssize_t) written;
+}
+
+ssize_t io_send_all(const int sock, const void *buf, const size_t n, const int flags) {
+    size_t sent = 0;
+
+    while (sent < n) {
+        const ssize_t sb = send(sock, (const char *) buf + sent, n - sent, flags | MSG_NOSIGNAL);
+        if (sb == -1 && errno == EINTR) {
+            continue;
+        }
+        if (sb <= 0) {
+            break;
+        }
+        sent += sb;
+    }
+
+    return sent;
+}
+
+bool io_batch_add(IoBatch *batch, const void *buf, const size_t n) {
+    if (batch->count == IO_BATCH_MAX) {
+        return false;
+    }
+
+    batch->iov[batch->count].iov_base = (void *) buf;
+    batch->iov[batch->count].iov_len = n;
+    batch->count++;
+    batch->bytes += n;
+    return true;
+}
+
+bool io_batch_copy(IoBatch *batch, const void *buf, const size_t n) {
+    if (n > IO_BATCH_COPY - batch->copy_len) {
+        return false;
+    }
+
+    // the copy area never moves, so earlier copies in the batch stay where they point
+    char *dst = batch->copy + batch->copy_len;
+    if (!io_batch_add(batch, dst, n)) {
+        return false;
+    }
+    memcpy(dst, buf, n);
+    batch->copy_len += n;
+    return true;
+}
+
+ssize_t io_batch_flush(const int sock, IoBatch *batch, const int flags) {
+    struct msghdr msg = {.msg_iov = batch->iov, .msg_iovlen = batch->count};
+    size_t sent = 0;
+
+    while (sent < batch->bytes) {
+        const ssize_t sb = sendmsg(sock, &msg, flags | MSG_NOSIGNAL);
+        if (sb == -1 && errno == EINTR) {
+            continue;
+        }
+        if (sb <= 0) {
+            break;
+        }
+        sent += sb;
+
+        // skip what went out, partial writes leave the first remaining buffer partly sent
+        size_t skip = sb;
+        while (msg.msg_iovlen > 0 && skip >= msg.msg_iov->iov_len) {
+            skip -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen > 0) {
+            msg.msg_iov->iov_base = (char *) msg.msg_iov->iov_base + skip;
+            msg.msg_iov->iov_len -= skip;
+        }
+    }
+
+    batch->count = 0;
+    batch->bytes = 0;
+    batch->copy_len = 0;
+    return sent;
+}
+
+// copies n bytes of a file to a socket through userspace, without using the file offset (the fd
+// may be shared by several senders, see seb_fdcache.h)
+static ssize_t pread_send(const int sock, const int fd, const off_t offset, const size_t n) {
+    char buf[16384];
+    size_t sent = 0;
+
+    while (sent < n) {
+        const ssize_t rb = pread(fd, buf, n - sent < sizeof(buf) ? n - sent : sizeof(buf),
+            offset + sent);
+        if (rb == -1 && errno == EINTR) {
+            continue;
+        }
+        if (rb <= 0) {
+            break;
+        }
+
+        const ssize_t sb = io_send_all(sock, buf, rb, 0);
+        sent += sb;
+        if (sb < rb) {
+            break;
+        }
+    }
+
+    return sent > 0 || n == 0 ? (ssize_t) sent : -1;
+}
+
+ssize_t io_send_file(const int sock, const int fd, const off_t offset, const size_t n) {
+    off_t off = offset;
+    size_t sent = 0;
+
+    while (sent < n) {
+        const size_t want = n - sent < _SENDFILE_MAX ? n - sent : _SENDFILE_MAX;
+        const ssize_t sb = sendfile(sock, fd, &off, want);
+
+        if (sb > 0) {
+            // a partial send just means the socket buffer filled up, off has been advanced
+            sent += sb;
+            continue;
+        }
+
+        if (sb == 0) {
+            // the file ended early (it was truncated under us), there is nothing more to send
+            break;
+        }
+
+        if (errno == EINTR || errno == EAGAIN) {
+            continue;
+        }
+
+        if ((errno == EINVAL || errno == ENOSYS) && sent == 0) {
+            // this file can't be sendfile'd (e.g. not mmap-able), copy it through userspace
+            return pread_send(sock, fd, offset, n);
+        }
+
+        return sent > 0 ? (ssize_t) sent : -1;
+    }
+
+    return sent;
+}
+
+ssize_t io_send_mapped(const int sock, const int fd, const off_t offset, const size_t n) {
+    if (n == 0) {
+        return 0;
+    }
+
+    // mappings must start on a page boundary
+    const off_t page_off = offset % sysconf(_SC_PAGESIZE);
+    const size_t map_len = n + page_off;
+
+    char *map = mmap(NULL, map_len, PROT_READ, MAP_SHARED, fd, offset - page_off);
+    if (map == MAP_FAILED) {
+        return io_send_file(sock, fd, offset, n);
+    }
+
+    // we read it front to back, once: read ahead aggressively and drop pages behind us
+    madvise(map, map_len, MADV_SEQUENTIAL);
+    madvise(map, map_len, MADV_WILLNEED);
+
+    // NOTE: nothing here may touch the mapping directly, see seb_io.h
+    const ssize_t sent = io_send_all(sock, map + page_off, n, 0);
+
+    munmap(map, map_len);
+    return sent > 0 ? sent : -1;
+}
+
+ssize_t io_recv_file(const int sock, const int fd, const size_t n, const int flags) {
+    if (flags & IO_PIPELINE) {
+        Copier *cp = copier_get();
+        if (cp != NULL) {
+            return recv_pipelined(cp, sock, fd, n, flags);
+        }
+        // no helper thread, splice instead
+    }
+
+    SplicePipe *p = pipe_get();
+    if (p == NULL) {
+        return pass_n_bytes(sock, fd, n);
+    }
+
+    size_t moved = 0;
+
+    DropWindow drop;
+    if (flags & IO_DROP_CACHE) {
+        drop_window_init(&drop, fd);
+    }
+
+    while (moved < n) {
+        const size_t want = n - moved < p->size ? n - moved : p->size;
+        const ssize_t in = splice(sock, NULL, p->wr, NULL, want, SPLICE_F_MOVE | SPLICE_F_MORE);
+
+        if (in == 0) {
+            // short read, the client closed the connection before sending the whole body
+            break;
+        }
+
+        if (in == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EINVAL && moved == 0) {
+                // splicing from this socket isn't supported, copy the old way
+                return pass_n_bytes(sock, fd, n);
+            }
+            // anything else (including a receive timeout) ends the body here
+            break;
+        }
+
+        // the pipe now holds in bytes, all of them must end up in the file
+        size_t left = in;
+        while (left > 0) {
+            const ssize_t out = splice(p->rd, NULL, fd, NULL, left, SPLICE_F_MOVE);
+
+            if (out > 0) {
+                left -= out;
+            } else if (out == -1 && errno == EINTR) {
+                continue;
+            } else if (out == -1 && errno == EINVAL) {
+                // the file system doesn't support splice, empty the pipe and copy the rest
+                if (pipe_copy_out(p, fd, left) == -1) {
+                    pipe_discard(p);
+                    return -1;
+                }
+
+                moved += in;
+                const ssize_t rest = n > moved ? pass_n_bytes(sock, fd, n - moved) : 0;
+                // failing like the other pass_n_bytes fallbacks, not as a short body
+                return rest == -1 ? -1 : (ssize_t) moved + rest;
+            } else {
+                // write error (e.g. disk full), the pipe still holds data we can't use
+                pipe_discard(p);
+                return -1;
+            }
+        }
+
+        moved += in;
+
+        if (flags & IO_DROP_CACHE) {
+            drop_window_advance(&drop, fd, moved);
+        }
+    }
+
+    return moved;
+}
+
+void io_preallocate(const int fd, const off_t n) {
+    // KEEP_SIZE, so a body that is cut short doesn't leave the file padded out to n
+    if (n > 0) {
+        fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, n);
+    }
+}
+
+void io_drop_cache(const int fd) {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+}
@@ -0,0 +1,158 @@
+/**
+ * @file seb_io.h
+ *
+ * Zero-copy (or fewer-copy) transfers between files and sockets
+ *
+ * These move data inside the kernel where possible, and fall back to the plain read/write copy
+ * (pass_n_bytes) when the kernel or the file system does not support it.
+ *
+ * @author Sebastian Law
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/**
+ * @brief Sends all n bytes of a buffer to a socket, with as few sends as the socket allows
+ *
+ * MSG_NOSIGNAL is always added, a client that went away is an error rather than a SIGPIPE.
+ *
+ * @param sock The socket to send to
+ * @param buf The data to send
+ * @param n The number of bytes to send
+ * @param flags Flags for send(2), e.g. MSG_MORE if a body follows
+ * @return The number of bytes sent, less than n only if an error occurred
+*/
+ssize_t io_send_all(const int sock, const void *buf, const size_t n, const int flags);
+
+// the most buffers an IoBatch collects before it must be flushed
+#define IO_BATCH_MAX 16
+// room in an IoBatch for data it copies
+#define IO_BATCH_COPY 4096
+
+/**
+ * @struct IoBatch
+ * @brief Buffers collected to be sent to a socket together, with one sendmsg (a writev with
+ * send flags)
+ *
+ * Buffers are either referenced, and must stay valid until the batch is flushed, or copied into
+ * the batch. Start from a zeroed IoBatch.
+*/
+typedef struct {
+    struct iovec iov[IO_BATCH_MAX];
+    int count;
+    // what is in iov, in bytes
+    size_t bytes;
+
+    char copy[IO_BATCH_COPY];
+    size_t copy_len;
+} IoBatch;
+
+/**
+ * @brief Adds a buffer to a batch, without copying it
+ *
+ * @return false if the batch is full, flush it and add again
+*/
+bool io_batch_add(IoBatch *batch, const void *buf, const size_t n);
+
+/**
+ * @brief Adds a copy of a buffer to a batch, so buf may be reused right away
+ *
+ * @return false if the batch has no room for it, flush it and add again (if n is at most
+ * IO_BATCH_COPY)
+*/
+bool io_batch_copy(IoBatch *batch, const void *buf, const size_t n);
+
+/**
+ * @brief Sends everything in a batch, resuming after partial writes, and empties it
+ *
+ * Sends nothing if the batch is empty. A client that went away is an error rather than a SIGPIPE.
+ *
+ * @param sock The socket to send to
+ * @param batch The batch to send
+ * @param flags MSG_MORE if more data follows right away, otherwise 0
+ * @return The number of bytes sent, less than the size of the batch only if an error occurred
+*/
+ssize_t io_batch_flush(const int sock, IoBatch *batch, const int flags);
+
+/**
+ * @brief Sends n bytes of a file to a socket, starting at an offset in the file
+ *
+ * Uses sendfile(2), resuming after partial sends, and copies through userspace with pread
+ * if sendfile is not supported for this file. The file offset is never used or moved, so
+ * several senders can share the fd.
+ *
+ * @param sock The socket to send to
+ * @param fd The file to send from, its file offset is not used by sendfile
+ * @param offset Where in the file to start
+ * @param n The number of bytes to send
+ * @return The number of bytes sent, which is less than n if the file is shorter than expected,
+ * or -1 if nothing could be sent because of an error
+*/
+ssize_t io_send_file(const int sock, const int fd, const off_t offset, const size_t n);
+
+/**
+ * @brief Sends n bytes of a file to a socket from a memory mapping of the file
+ *
+ * The mapping is advised MADV_SEQUENTIAL and MADV_WILLNEED, and only ever read by the kernel
+ * (inside send), never by us. So if the file is truncated while it is being sent, the send fails
+ * with EFAULT and the transfer stops short, instead of a SIGBUS killing the process.
+ * Falls back to io_send_file if the file can't be mapped.
+ *
+ * @param sock The socket to send to
+ * @param fd The file to send from
+ * @param offset Where in the file to start
+ * @param n The number of bytes to send
+ * @return The number of bytes sent, which is less than n if the file is shorter than expected,
+ * or -1 if nothing could be sent because of an error
+*/
+ssize_t io_send_mapped(const int sock, const int fd, const off_t offset, const size_t n);
+
+// io_recv_file flag: keep the upload from filling the page cache, see io_drop_cache
+#define IO_DROP_CACHE 1
+// io_recv_file flag: overlap receiving and writing with a helper thread, instead of splicing
+#define IO_PIPELINE 2
+
+/**
+ * @brief Receives n bytes from a socket into a file, at the file's current offset
+ *
+ * Uses splice(2) through a pipe owned by the calling thread (socket -> pipe -> file), so the data
+ * never enters userspace. Copies through userspace if splice is not supported for this file.
+ *
+ * With IO_DROP_CACHE, the file is written back in windows as it arrives, and each window is
+ * dropped from the page cache once it is on disk, so a bulk upload doesn't evict the files being
+ * read. Call io_drop_cache once the whole file is written, for the last window.
+ *
+ * With IO_PIPELINE, the body is copied through two 1 MiB buffers instead: the calling thread
+ * receives into one while a helper thread (one per calling thread, started on first use) writes
+ * the other to the file. Splicing takes turns between the socket and the file, this keeps both
+ * busy, which pays off when writes block on a slow disk.
+ *
+ * @param sock The socket to receive from
+ * @param fd The file to write to
+ * @param n The number of bytes to receive
+ * @param flags 0, or IO_DROP_CACHE and/or IO_PIPELINE
+ * @return The number of bytes written to the file, which is less than n if the client closed the
+ * connection early, stopped sending (a receive timeout) or a receive failed, or -1 if writing to
+ * the file failed, so the caller can tell the client's fault from ours
+*/
+ssize_t io_recv_file(const int sock, const int fd, const size_t n, const int flags);
+
+/**
+ * @brief Reserves disk space for the first n bytes of a file, without changing its size
+ *
+ * Lets the file system lay the file out in one go instead of growing it write by write.
+ * This is only a hint, file systems that can't do it are left alone.
+*/
+void io_preallocate(const int fd, const off_t n);
+
+/**
+ * @brief Writes a file back to disk and drops it from the page cache
+ *
+ * Only clean pages can be dropped, which is why this waits for the writeback first.
+*/
+void io_drop_cache(const int fd);
@@ -0,0 +1,254 @@
+#include "seb_objcache.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define _NUM_SHARDS 16
+// hash buckets per shard, chains stay short for a few thousand objects
+#define _SHARD_BUCKETS 1024
+
+// no single object takes more than this, nor more than a fraction of its shard
+#define _MAX_OBJECT (256 * 1024)
+#define _MAX_OBJECT_SHARE 8
+
+typedef struct {
+    pthread_mutex_t mutex;
+    CachedObject *buckets[_SHARD_BUCKETS];
+    // LRU list, evictions take from the tail
+    CachedObject *head;
+    CachedObject *tail;
+    size_t bytes;
+} Shard;
+
+static Shard _shards[_NUM_SHARDS];
+static size_t _shard_max_bytes = 0;
+static size_t _max_object = 0;
+
+static unsigned uri_hash(const char *uri) {
+    // FNV-1a
+    unsigned h = 2166136261u;
+    for (; *uri != '\0'; uri++) {
+        h = (h ^ (unsigned char) *uri) * 16777619u;
+    }
+    return h;
+}
+
+static Shard *shard_of(const unsigned hash) {
+    return &_shards[hash % _NUM_SHARDS];
+}
+
+// what an object counts against the byte cap
+static size_t footprint(const CachedObject *obj) {
+    return sizeof(CachedObject) + obj->len + strlen(obj->uri) + 1;
+}
+
+static void lru_unlink(Shard *sh, CachedObject *obj) {
+    if (obj->prev != NULL) {
+        obj->prev->next = obj->next;
+    } else {
+        sh->head = obj->next;
+    }
+    if (obj->next != NULL) {
+        obj->next->prev = obj->prev;
+    } else {
+        sh->tail = obj->prev;
+    }
+    obj->prev = obj->next = NULL;
+}
+
+static void lru_push_front(Shard *sh, CachedObject *obj) {
+    obj->prev = NULL;
+    obj->next = sh->head;
+    if (sh->head != NULL) {
+        sh->head->prev = obj;
+    } else {
+        sh->tail = obj;
+    }
+    sh->head = obj;
+}
+
+// returns a pointer to the link pointing at the object of uri, which is NULL if there is none
+static CachedObject **find(Shard *sh, const unsigned hash, const char *uri) {
+    CachedObject **link = &sh->buckets[(hash / _NUM_SHARDS) % _SHARD_BUCKETS];
+    while (*link != NULL && strcmp((*link)->uri, uri) != 0) {
+        link = &(*link)->chain;
+    }
+    return link;
+}
+
+static void object_free(CachedObject *obj) {
+    free(obj->uri);
+    free(obj);
+}
+
+// takes the object at link out of its shard, returns whether the caller must free it
+// (after unlocking)
+static bool remove_at(Shard *sh, CachedObject **link) {
+    CachedObject *obj = *link;
+    *link = obj->chain;
+    lru_unlink(sh, obj);
+    obj->cached = false;
+    sh->bytes -= footprint(obj);
+    return --obj->refs == 0;
+}
+
+void objcache_init(const size_t max_bytes) {
+    for (int i = 0; i < _NUM_SHARDS; i++) {
+        pthread_mutex_init(&_shards[i].mutex, NULL);
+    }
+
+    _shard_max_bytes = max_bytes / _NUM_SHARDS;
+    _max_object = _shard_max_bytes / _MAX_OBJECT_SHARE;
+    if (_max_object > _MAX_OBJECT) {
+        _max_object = _MAX_OBJECT;
+    }
+}
+
+size_t objcache_max_object(void) {
+    return _max_object;
+}
+
+CachedObject *objcache_get(const char *uri) {
+    if (_max_object == 0) {
+        return NULL;
+    }
+
+    const unsigned hash = uri_hash(uri);
+    Shard *sh = shard_of(hash);
+
+    pthread_mutex_lock(&sh->mutex);
+    CachedObject *obj = *find(sh, hash, uri);
+    if (obj != NULL) {
+        obj->refs++;
+        lru_unlink(sh, obj);
+        lru_push_front(sh, obj);
+    }
+    pthread_mutex_unlock(&sh->mutex);
+
+    return obj;
+}
+
+CachedObject *objcache_read(
+    const char *headers, const size_t headers_len, const int fd, const struct stat *st) {
+    const size_t size = st->st_size;
+    if (size > _max_object) {
+        return NULL;
+    }
+
+    CachedObject *obj = malloc(sizeof(CachedObject) + headers_len + size);
+    if (obj == NULL) {
+        return NULL;
+    }
+
+    memset(obj, 0, sizeof(CachedObject));
+    obj->refs = 1;
+    obj->st = *st;
+    obj->len = headers_len + size;
+    memcpy(obj->data, headers, headers_len);
+
+    size_t got = 0;
+    while (got < size) {
+        const ssize_t rb = pread(fd, obj->data + headers_len + got, size - got, got);
+        if (rb == -1 && errno == EINTR) {
+            continue;
+        }
+        if (rb <= 0) {
+            // the file is shorter than it said, or unreadable: don't cache a wrong body
+            free(obj);
+            return NULL;
+        }
+        got += rb;
+    }
+
+    return obj;
+}
+
+void objcache_insert(const char *uri, CachedObject *obj) {
+    obj->uri = strdup(uri);
+    if (obj->uri == NULL) {
+        return;
+    }
+
+    const unsigned hash = uri_hash(uri);
+    Shard *sh = shard_of(hash);
+    const size_t size = footprint(obj);
+
+    // evicted objects are freed after unlocking
+    CachedObject *freed = NULL;
+
+    pthread_mutex_lock(&sh->mutex);
+
+    CachedObject **link = find(sh, hash, uri);
+    if (*link != NULL) {
+        CachedObject *old = *link;
+        if (remove_at(sh, link)) {
+            old->chain = freed;
+            freed = old;
+        }
+    }
+
+    while (sh->tail != NULL && sh->bytes + size > _shard_max_bytes) {
+        CachedObject *victim = sh->tail;
+        if (remove_at(sh, find(sh, uri_hash(victim->uri), victim->uri))) {
+            victim->chain = freed;
+            freed = victim;
+        }
+    }
+
+    // the cache holds its own reference
+    obj->refs++;
+    obj->cached = true;
+    link = find(sh, hash, uri);
+    obj->chain = NULL;
+    *link = obj;
+    lru_push_front(sh, obj);
+    sh->bytes += size;
+
+    pthread_mutex_unlock(&sh->mutex);
+
+    while (freed != NULL) {
+        CachedObject *next = freed->chain;
+        object_free(freed);
+        freed = next;
+    }
+}
+
+void objcache_release(CachedObject *obj) {
+    if (obj->uri == NULL) {
+        // never inserted, only the caller knows of it
+        object_free(obj);
+        return;
+    }
+
+    Shard *sh = shard_of(uri_hash(obj->uri));
+
+    pthread_mutex_lock(&sh->mutex);
+    const bool last = --obj->refs == 0;
+    pthread_mutex_unlock(&sh->mutex);
+
+    if (last) {
+        object_free(obj);
+    }
+}
+
+void objcache_invalidate(const char *uri) {
+    if (_max_object == 0) {
+        return;
+    }
+
+    const unsigned hash = uri_hash(uri);
+    Shard *sh = shard_of(hash);
+
+    pthread_mutex_lock(&sh->mutex);
+    CachedObject **link = find(sh, hash, uri);
+    CachedObject *obj = *link;
+    const bool last = obj != NULL && remove_at(sh, link);
+    pthread_mutex_unlock(&sh->mutex);
+
+    if (last) {
+        object_free(obj);
+    }
+}
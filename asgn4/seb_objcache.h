@@ -0,0 +1,97 @@
+/**
+ * @file seb_objcache.h
+ *
+ * A byte-capped LRU cache of small files, kept as complete serialized 200 responses
+ *
+ * A hit answers a GET with a single send of the cached response, without touching the file
+ * system. The cache is split into shards by URI hash, each with its own lock, LRU list and share
+ * of the byte budget, so threads hitting different URIs rarely contend.
+ *
+ * Objects are immutable and reference counted, so a response can be sent after the URI lock is
+ * released even if the entry is replaced or evicted meanwhile. Like the fd cache
+ * (seb_fdcache.h), this cache does not notice files changing: fills and invalidations must
+ * happen under the URI lock (fills under the reader lock at least, invalidations and write-through
+ * under the writer lock).
+ *
+ * All functions are thread safe.
+ *
+ * @author Sebastian Law
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/stat.h>
+
+/**
+ * @struct CachedObject
+ * @brief A complete 200 response: headers and body
+ *
+ * Holders may read st, len and data, the rest belongs to the cache.
+*/
+typedef struct cached_object {
+    char *uri;
+    // one for every holder, plus one for the cache itself while the object is in it
+    int refs;
+    bool cached;
+    // the hash chain, and the LRU list of the shard (most recently used first)
+    struct cached_object *chain;
+    struct cached_object *prev;
+    struct cached_object *next;
+
+    // the stat of the file the body was read from
+    struct stat st;
+
+    size_t len;
+    char data[];
+} CachedObject;
+
+/**
+ * @brief Sets up the cache, call once at startup
+ *
+ * @param max_bytes The most memory cached objects may take, 0 disables the cache
+*/
+void objcache_init(const size_t max_bytes);
+
+/**
+ * @brief Returns the largest file (body) the cache takes, 0 if it is disabled
+*/
+size_t objcache_max_object(void);
+
+/**
+ * @brief Looks up a URI, returns a reference to its object, or NULL if it isn't cached
+*/
+CachedObject *objcache_get(const char *uri);
+
+/**
+ * @brief Builds an object from response headers and a file, without caching it yet
+ *
+ * The file offset is not used.
+ *
+ * @param headers The status line and headers, up to and including the blank line
+ * @param headers_len The length of headers
+ * @param fd The file to read the body from
+ * @param st The stat of the file, st_size bytes are read
+ * @return A reference to the object, or NULL if the body is too large for the cache, the file
+ * can't be read in full, or the cache is disabled
+*/
+CachedObject *objcache_read(
+    const char *headers, const size_t headers_len, const int fd, const struct stat *st);
+
+/**
+ * @brief Caches an object from objcache_read under a URI, replacing what was cached for it
+ *
+ * The caller keeps its reference.
+*/
+void objcache_insert(const char *uri, CachedObject *obj);
+
+/**
+ * @brief Gives back a reference from objcache_get or objcache_read
+*/
+void objcache_release(CachedObject *obj);
+
+/**
+ * @brief Drops a URI from the cache, the next objcache_get of it misses
+*/
+void objcache_invalidate(const char *uri);
@@ -0,0 +1,316 @@
+// SO_INCOMING_CPU needs the Linux socket options
+#define _GNU_SOURCE
+
+#include "seb_reactor.h"
+
+#include "asgn2_helper_funcs.h"
+
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// how many events one epoll_wait takes
+#define _MAX_EVENTS 256
+// how often a reactor checks for idle connections and whether the server is stopping
+#define _WAIT_MS 1000
+// the backlog of listening sockets from reactor_listen
+#define _BACKLOG 128
+
+struct reactor {
+    int epoll_fd;
+    int listen_fd;
+    queue_t *queue;
+    void (*serve)(ReactorConn *);
+    int idle_secs;
+
+    // the thread running the reactor, set by reactor_run
+    pthread_t thread;
+
+    // written by other threads giving connections back, with the connections on returned
+    int wake_fd;
+    pthread_mutex_t returned_mutex;
+    ReactorConn *returned;
+
+    // the connections waiting for (the rest of) a request, longest waiting first
+    // only the reactor thread touches these
+    ReactorConn *head;
+    ReactorConn *tail;
+
+    // the connections of one epoll_wait with a complete request, pushed to the queue together
+    // every event completes at most one
+    void *ready[_MAX_EVENTS];
+    int ready_count;
+};
+
+static time_t now_secs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+static void list_unlink(Reactor *r, ReactorConn *conn) {
+    if (conn->prev != NULL) {
+        conn->prev->next = conn->next;
+    } else {
+        r->head = conn->next;
+    }
+    if (conn->next != NULL) {
+        conn->next->prev = conn->prev;
+    } else {
+        r->tail = conn->prev;
+    }
+    conn->prev = conn->next = NULL;
+}
+
+static void list_push_back(Reactor *r, ReactorConn *conn) {
+    conn->next = NULL;
+    conn->prev = r->tail;
+    if (r->tail != NULL) {
+        r->tail->next = conn;
+    } else {
+        r->head = conn;
+    }
+    r->tail = conn;
+}
+
+// frees a connection with nothing in flight, no need to drain it
+static void conn_drop(ReactorConn *conn) {
+    // closing the socket also takes it out of the epoll set
+    close(conn->fd);
+    req_free(conn->req);
+    free(conn);
+}
+
+// waits for the connection to be readable again, once, keeping its place among the waiting
+static void conn_rearm(ReactorConn *conn) {
+    Reactor *r = conn->owner;
+
+    // one-shot, so a connection only ever wakes the reactor while the reactor has it
+    struct epoll_event ev = {.events = EPOLLIN | EPOLLONESHOT, .data.ptr = conn};
+    const int op = conn->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    conn->registered = true;
+
+    if (epoll_ctl(r->epoll_fd, op, conn->fd, &ev) == -1) {
+        list_unlink(r, conn);
+        conn_drop(conn);
+    }
+}
+
+// starts waiting for the next request on the connection
+// the idle timeout runs from here, not from the last read, so a client trickling in its request
+// a byte at a time can't hold the connection forever
+static void conn_wait(ReactorConn *conn, const time_t now) {
+    conn->active = now;
+    list_push_back(conn->owner, conn);
+    conn_rearm(conn);
+}
+
+// hands a connection with a complete request to whoever serves it
+static void conn_dispatch(ReactorConn *conn) {
+    Reactor *r = conn->owner;
+    if (r->queue != NULL) {
+        r->ready[r->ready_count++] = conn;
+    } else {
+        r->serve(conn);
+    }
+}
+
+// pushes what conn_dispatch collected, with one wakeup of the workers rather than one each
+static void push_ready(Reactor *r) {
+    if (r->ready_count > 0) {
+        queue_push_many(r->queue, r->ready, r->ready_count);
+        r->ready_count = 0;
+    }
+}
+
+static void accept_all(Reactor *r, const time_t now) {
+    Listener_Socket listener = {.fd = r->listen_fd};
+    const struct timeval timeout = {.tv_sec = r->idle_secs};
+    int fd;
+
+    // the listener is non-blocking, this stops once the backlog is empty
+    while ((fd = listener_accept(&listener)) != -1) {
+        ReactorConn *conn = calloc(1, sizeof(ReactorConn));
+        if (conn == NULL) {
+            close(fd);
+            continue;
+        }
+
+        // the reactor only reads without blocking, this bounds the blocking reads of whoever serves
+        // the connection (the body of a PUT, the drain before closing)
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        conn->owner = r;
+        conn->fd = fd;
+        conn->req = req_create(fd);
+        conn_wait(conn, now);
+    }
+}
+
+static void conn_readable(ReactorConn *conn) {
+    switch (req_parse_nb(conn->req)) {
+    case PARSE_AGAIN:
+        // still the same request, it keeps its place among the waiting (and its deadline)
+        conn_rearm(conn);
+        break;
+    case PARSE_INVALID:
+        list_unlink(conn->owner, conn);
+        if (!req_has_data(conn->req)) {
+            // the client closed the connection between requests, nothing to answer
+            conn_drop(conn);
+            break;
+        }
+        // the request is answered with a 400 like any other
+        conn_dispatch(conn);
+        break;
+    case PARSE_DONE:
+        list_unlink(conn->owner, conn);
+        conn_dispatch(conn);
+        break;
+    }
+}
+
+// takes the connections other threads gave back
+static void take_returned(Reactor *r, const time_t now) {
+    uint64_t count;
+    (void) !read(r->wake_fd, &count, sizeof(count));
+
+    pthread_mutex_lock(&r->returned_mutex);
+    ReactorConn *conn = r->returned;
+    r->returned = NULL;
+    pthread_mutex_unlock(&r->returned_mutex);
+
+    while (conn != NULL) {
+        ReactorConn *next = conn->next;
+        conn_wait(conn, now);
+        conn = next;
+    }
+}
+
+static void close_idle(Reactor *r, const time_t now) {
+    while (r->head != NULL && now - r->head->active >= r->idle_secs) {
+        ReactorConn *conn = r->head;
+        list_unlink(r, conn);
+        conn_drop(conn);
+    }
+}
+
+int reactor_listen(const int port, const int cpu) {
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return -1;
+    }
+
+    const int one = 1;
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == -1
+        || setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) == -1
+        || (cpu >= 0 && setsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) == -1)
+        || bind(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1 || listen(fd, _BACKLOG) == -1) {
+        const int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+
+    return fd;
+}
+
+Reactor *reactor_new(
+    const int listen_fd, queue_t *queue, void (*serve)(ReactorConn *), const int idle_secs) {
+    const int flags = fcntl(listen_fd, F_GETFL);
+    if (flags == -1 || fcntl(listen_fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+        return NULL;
+    }
+
+    Reactor *r = calloc(1, sizeof(Reactor));
+    if (r == NULL) {
+        return NULL;
+    }
+
+    r->listen_fd = listen_fd;
+    r->queue = queue;
+    r->serve = serve;
+    r->idle_secs = idle_secs;
+    pthread_mutex_init(&r->returned_mutex, NULL);
+
+    r->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    r->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    // the listener and the wake up are told apart from connections by their data
+    struct epoll_event listen_ev = {.events = EPOLLIN, .data.ptr = NULL};
+    struct epoll_event wake_ev = {.events = EPOLLIN, .data.ptr = &r->wake_fd};
+
+    if (r->epoll_fd == -1 || r->wake_fd == -1
+        || epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, listen_fd, &listen_ev) == -1
+        || epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, r->wake_fd, &wake_ev) == -1) {
+        const int err = errno;
+        close(r->epoll_fd);
+        close(r->wake_fd);
+        free(r);
+        errno = err;
+        return NULL;
+    }
+
+    return r;
+}
+
+void reactor_run(Reactor *r, volatile bool *running) {
+    struct epoll_event events[_MAX_EVENTS];
+    r->thread = pthread_self();
+
+    while (*running) {
+        const int n = epoll_wait(r->epoll_fd, events, _MAX_EVENTS, _WAIT_MS);
+
+        for (int i = 0; i < n; i++) {
+            void *ptr = events[i].data.ptr;
+            if (ptr == NULL) {
+                accept_all(r, now_secs());
+            } else if (ptr == &r->wake_fd) {
+                take_returned(r, now_secs());
+            } else {
+                conn_readable(ptr);
+            }
+        }
+
+        push_ready(r);
+        close_idle(r, now_secs());
+    }
+}
+
+void reactor_return(ReactorConn *conn) {
+    Reactor *r = conn->owner;
+    if (pthread_equal(r->thread, pthread_self())) {
+        // served on the reactor thread, no need to wake it
+        conn_wait(conn, now_secs());
+        return;
+    }
+
+    pthread_mutex_lock(&r->returned_mutex);
+    conn->next = r->returned;
+    r->returned = conn;
+    pthread_mutex_unlock(&r->returned_mutex);
+
+    const uint64_t one = 1;
+    (void) !write(r->wake_fd, &one, sizeof(one));
+}
+
+void reactor_close(ReactorConn *conn) {
+    req_close(conn->req);
+    req_free(conn->req);
+    free(conn);
+}
@@ -0,0 +1,97 @@
+/**
+ * @file seb_reactor.h
+ *
+ * An epoll front end that owns connections while they wait for a request
+ *
+ * A reactor thread accepts connections and reads their request line and headers without
+ * blocking (req_parse_nb). Only once a request is complete (or invalid) is the connection served:
+ * either pushed to the queue of a worker pool, or served right there on the reactor thread. So a
+ * slow or idle client costs a parked ReactorConn and its Request, never a thread. Whoever served
+ * a request then either closes the connection or gives it back with reactor_return to wait for
+ * the next one.
+ *
+ * Connections that don't complete their request within the idle timeout of starting to wait for
+ * it are closed by the reactor, however slowly they keep sending.
+ *
+ * Several reactors can run at once, e.g. one per thread, each with its own listening socket
+ * (see reactor_listen).
+ *
+ * @author Sebastian Law
+*/
+
+#pragma once
+
+#include "queue.h"
+#include "seb_http.h"
+
+#include <stdbool.h>
+#include <time.h>
+
+typedef struct reactor Reactor;
+
+/**
+ * @struct ReactorConn
+ * @brief A connection and the request being read from it
+ *
+ * Workers may use req, the rest belongs to the reactor.
+*/
+typedef struct reactor_conn {
+    Request *req;
+
+    Reactor *owner;
+    int fd;
+    // when the connection started waiting for its request, in seconds of CLOCK_MONOTONIC
+    time_t active;
+    // whether fd is in the epoll set yet
+    bool registered;
+    // the list of waiting connections (longest waiting first), or of those given back
+    struct reactor_conn *prev;
+    struct reactor_conn *next;
+} ReactorConn;
+
+/**
+ * @brief Opens a listening socket on a port, which other such sockets can share (SO_REUSEPORT)
+ *
+ * The kernel spreads new connections over the sockets sharing the port.
+ *
+ * @param port The port to listen on, on all interfaces
+ * @param cpu With SO_INCOMING_CPU, prefer connections the kernel received on this CPU, so they are
+ * served where they arrived. -1 to leave the kernel's spreading alone.
+ * @return The socket, or -1 with errno set on error
+*/
+int reactor_listen(const int port, const int cpu);
+
+/**
+ * @brief Sets up a reactor
+ *
+ * Connections with a complete request are pushed to queue (as ReactorConn *), all those of one
+ * epoll_wait at once (queue_push_many), or if queue is NULL, passed to serve on the reactor thread.
+ * A serve that blocks holds up every connection of the reactor.
+ *
+ * @param listen_fd The listening socket, it is made non-blocking
+ * @param queue Where connections with a complete request are pushed, or NULL
+ * @param serve What connections with a complete request are passed to if queue is NULL
+ * @param idle_secs How long a connection may take to send a whole request head, also the receive
+ * timeout (SO_RCVTIMEO) of every connection accepted, so no blocking read waits longer
+ * @return The reactor, or NULL with errno set on error
+*/
+Reactor *reactor_new(
+    const int listen_fd, queue_t *queue, void (*serve)(ReactorConn *), const int idle_secs);
+
+/**
+ * @brief Runs a reactor on the calling thread, until *running is false
+*/
+void reactor_run(Reactor *reactor, volatile bool *running);
+
+/**
+ * @brief Gives a connection back to the reactor, to wait for its next request
+ *
+ * req must be ready for the next request (see req_next). Any part of it that is already buffered
+ * and parsed is kept. Thread safe, and cheapest on the reactor's own thread.
+*/
+void reactor_return(ReactorConn *conn);
+
+/**
+ * @brief Closes a connection a worker is done with, after its last response (see req_close)
+*/
+void reactor_close(ReactorConn *conn);
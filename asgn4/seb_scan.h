@@ -0,0 +1,61 @@
+/**
+ * @file seb_scan.h
+ *
+ * Vectorized scanning of character classes used by the request parser
+ *
+ * The scanners use SSE2 on x86-64 (or AVX2 when built with -DSCAN_AVX2 and the CPU supports it,
+ * checked once at startup), and fall back to a scalar loop otherwise.
+ *
+ * @author Sebastian Law
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @enum ScanClass
+ * @brief The character classes that can be scanned
+ *
+ * These are the classes that fields of the request grammar (seb_http_grammar.h) are made of.
+*/
+typedef enum {
+    // not a scannable class
+    SCAN_NONE,
+    // [a-zA-Z], methods
+    SCAN_ALPHA,
+    // [a-zA-Z0-9\.-], URIs and header keys
+    // note that inside a POSIX bracket expression the backslash is a literal, so it is included
+    SCAN_TOKEN,
+    // [ -~], printable ASCII, header values
+    SCAN_PRINT,
+} ScanClass;
+
+#define SCAN_NUM_CLASSES 4
+
+/**
+ * @brief Returns whether a byte is in a character class
+*/
+static inline bool scan_class_has(const ScanClass cls, const unsigned char c) {
+    switch (cls) {
+    case SCAN_ALPHA: return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    case SCAN_TOKEN:
+        return scan_class_has(SCAN_ALPHA, c) || (c >= '0' && c <= '9') || c == '.' || c == '-'
+               || c == '\\';
+    case SCAN_PRINT: return c >= ' ' && c <= '~';
+    case SCAN_NONE: return false;
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the length of the run of bytes in a character class at the start of a buffer
+ *
+ * @param cls The character class to scan for
+ * @param buf The buffer to scan
+ * @param n The number of bytes in the buffer
+ * @return The number of leading bytes in buf that are in cls, at most n.
+ * This is the position of the first delimiter (or invalid byte) in buf.
+*/
+size_t scan_span(const ScanClass cls, const char *buf, const size_t n);
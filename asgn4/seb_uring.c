@@ -0,0 +1,181 @@
+#include "seb_uring.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+static int sys_io_uring_setup(const unsigned entries, struct io_uring_params *p) {
+    return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(const int fd, const unsigned to_submit, const unsigned min_complete,
+    const unsigned flags, const void *arg, const size_t argsz) {
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+int ring_init(Ring *ring, const unsigned sq_entries, const unsigned cq_entries) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = cq_entries;
+
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = sys_io_uring_setup(sq_entries, &p);
+    if (ring->fd == -1) {
+        return -1;
+    }
+
+    if (!(p.features & IORING_FEAT_EXT_ARG)) {
+        // we need this (5.11) to wait with a timeout
+        close(ring->fd);
+        errno = ENOSYS;
+        return -1;
+    }
+
+    ring->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        // both rings live in the one mapping
+        if (ring->cq_len > ring->sq_len) {
+            ring->sq_len = ring->cq_len;
+        }
+        ring->cq_len = ring->sq_len;
+    }
+
+    ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        close(ring->fd);
+        return -1;
+    }
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) {
+            munmap(ring->sq_ptr, ring->sq_len);
+            close(ring->fd);
+            return -1;
+        }
+    }
+
+    ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        if (ring->cq_ptr != ring->sq_ptr) {
+            munmap(ring->cq_ptr, ring->cq_len);
+        }
+        munmap(ring->sq_ptr, ring->sq_len);
+        close(ring->fd);
+        return -1;
+    }
+
+    char *sq = ring->sq_ptr;
+    ring->sq_head = (unsigned *) (sq + p.sq_off.head);
+    ring->sq_tail = (unsigned *) (sq + p.sq_off.tail);
+    ring->sq_mask = *(unsigned *) (sq + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned *) (sq + p.sq_off.array);
+
+    char *cq = ring->cq_ptr;
+    ring->cq_head = (unsigned *) (cq + p.cq_off.head);
+    ring->cq_tail = (unsigned *) (cq + p.cq_off.tail);
+    ring->cq_mask = *(unsigned *) (cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+
+    // the sq array is an indirection we don't need, point every slot at the sqe of the same index
+    for (unsigned i = 0; i < p.sq_entries; i++) {
+        ring->sq_array[i] = i;
+    }
+
+    return 0;
+}
+
+void ring_destroy(Ring *ring) {
+    munmap(ring->sqes, ring->sqes_len);
+    if (ring->cq_ptr != ring->sq_ptr) {
+        munmap(ring->cq_ptr, ring->cq_len);
+    }
+    munmap(ring->sq_ptr, ring->sq_len);
+    close(ring->fd);
+}
+
+// publishes the pending entries to the kernel and submits them, returns -1 on error
+static int ring_enter(Ring *ring, const unsigned wait_nr, const long timeout_ms) {
+    // the kernel must see the entries before it sees the new tail
+    __atomic_store_n(ring->sq_tail, *ring->sq_tail + ring->sq_pending, __ATOMIC_RELEASE);
+    ring->sq_pending = 0;
+
+    // including any an earlier call failed to submit (EBUSY, EAGAIN), which are still in the queue
+    const unsigned to_submit = *ring->sq_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+    int res;
+    if (wait_nr > 0) {
+        struct __kernel_timespec ts = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000};
+        struct io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof(arg));
+        arg.ts = (uint64_t) (uintptr_t) &ts;
+
+        res = sys_io_uring_enter(ring->fd, to_submit, wait_nr,
+            IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    } else {
+        res = sys_io_uring_enter(ring->fd, to_submit, 0, 0, NULL, 0);
+    }
+
+    if (res == -1 && errno != ETIME && errno != EINTR) {
+        return -1;
+    }
+
+    return 0;
+}
+
+// makes sure n more entries fit in the submission queue
+static void ring_make_room(Ring *ring, const unsigned n) {
+    const unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (*ring->sq_tail + ring->sq_pending - head + n > ring->sq_mask + 1) {
+        // full, hand what we have to the kernel to make room
+        ring_enter(ring, 0, 0);
+    }
+}
+
+static struct io_uring_sqe *ring_next_sqe(Ring *ring) {
+    struct io_uring_sqe *sqe = &ring->sqes[(*ring->sq_tail + ring->sq_pending) & ring->sq_mask];
+    ring->sq_pending++;
+
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+struct io_uring_sqe *ring_get_sqe(Ring *ring) {
+    ring_make_room(ring, 1);
+    return ring_next_sqe(ring);
+}
+
+void ring_get_sqe_pair(Ring *ring, struct io_uring_sqe **first, struct io_uring_sqe **second) {
+    ring_make_room(ring, 2);
+    *first = ring_next_sqe(ring);
+    *second = ring_next_sqe(ring);
+}
+
+int ring_submit_and_wait(Ring *ring, const unsigned wait_nr, const long timeout_ms) {
+    return ring_enter(ring, wait_nr, timeout_ms);
+}
+
+struct io_uring_cqe *ring_peek_cqe(Ring *ring) {
+    const unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+
+    return &ring->cqes[head & ring->cq_mask];
+}
+
+void ring_cqe_seen(Ring *ring) {
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
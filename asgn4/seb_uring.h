@@ -0,0 +1,171 @@
+/**
+ * @file seb_uring.h
+ *
+ * A minimal io_uring wrapper, using the raw system calls (there is no liburing here)
+ *
+ * Only what the io_uring engine needs: setting up a ring, getting submission queue entries,
+ * preparing the operations it uses, submitting them and reaping completions.
+ *
+ * A ring must only be used by one thread at a time.
+ *
+ * @author Sebastian Law
+*/
+
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/**
+ * @struct Ring
+ * @brief An io_uring instance, with its submission and completion queues mapped
+*/
+typedef struct {
+    int fd;
+
+    // submission queue, shared with the kernel
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    // entries handed out by ring_get_sqe but not yet published to the kernel
+    unsigned sq_pending;
+
+    // completion queue, shared with the kernel
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe *cqes;
+
+    // the mappings, for ring_destroy
+    void *sq_ptr;
+    size_t sq_len;
+    void *cq_ptr;
+    size_t cq_len;
+    size_t sqes_len;
+} Ring;
+
+/**
+ * @brief Sets up a ring
+ *
+ * @param ring The ring to set up
+ * @param sq_entries The size of the submission queue
+ * @param cq_entries The size of the completion queue, at least sq_entries
+ * @return 0 on success, -1 with errno set on error (e.g. ENOSYS if io_uring is not available)
+*/
+int ring_init(Ring *ring, const unsigned sq_entries, const unsigned cq_entries);
+
+/**
+ * @brief Tears down a ring, any operations still in flight are cancelled
+*/
+void ring_destroy(Ring *ring);
+
+/**
+ * @brief Returns a zeroed submission queue entry to prepare an operation in
+ *
+ * If the submission queue is full, what is in it is submitted first.
+ * The entry is submitted with the next ring_submit_and_wait.
+*/
+struct io_uring_sqe *ring_get_sqe(Ring *ring);
+
+/**
+ * @brief Returns two zeroed submission queue entries, which are submitted together
+ *
+ * For an operation linked to the next (IOSQE_IO_LINK) like a timeout, the link only holds if both
+ * go to the kernel in the same submission, which ring_get_sqe can't promise.
+*/
+void ring_get_sqe_pair(Ring *ring, struct io_uring_sqe **first, struct io_uring_sqe **second);
+
+/**
+ * @brief Submits all prepared entries and waits for completions
+ *
+ * @param ring The ring
+ * @param wait_nr The number of completions to wait for, 0 to only submit
+ * @param timeout_ms The longest to wait, in milliseconds
+ * @return 0 on success (including timeouts), -1 with errno set on error. After EBUSY (the
+ * completion queue is full) or EAGAIN, reap completions and call again, which also submits the
+ * entries that weren't
+*/
+int ring_submit_and_wait(Ring *ring, const unsigned wait_nr, const long timeout_ms);
+
+/**
+ * @brief Returns the next completion, or NULL if there is none
+ *
+ * Call ring_cqe_seen once done with it.
+*/
+struct io_uring_cqe *ring_peek_cqe(Ring *ring);
+
+/**
+ * @brief Marks the completion returned by ring_peek_cqe as consumed
+*/
+void ring_cqe_seen(Ring *ring);
+
+// operation preparation
+// user_data is returned as is in the completion of the operation
+
+static inline void ring_prep(struct io_uring_sqe *sqe, const int op, const int fd, const void *addr,
+    const unsigned len, const uint64_t off, const uint64_t user_data) {
+    sqe->opcode = op;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t) (uintptr_t) addr;
+    sqe->len = len;
+    sqe->off = off;
+    sqe->user_data = user_data;
+}
+
+static inline void ring_prep_accept(struct io_uring_sqe *sqe, const int fd, const uint64_t data) {
+    ring_prep(sqe, IORING_OP_ACCEPT, fd, NULL, 0, 0, data);
+}
+
+static inline void ring_prep_recv(struct io_uring_sqe *sqe, const int fd, void *buf,
+    const unsigned len, const uint64_t data) {
+    ring_prep(sqe, IORING_OP_RECV, fd, buf, len, 0, data);
+}
+
+static inline void ring_prep_send(struct io_uring_sqe *sqe, const int fd, const void *buf,
+    const unsigned len, const int flags, const uint64_t data) {
+    ring_prep(sqe, IORING_OP_SEND, fd, buf, len, 0, data);
+    sqe->msg_flags = flags;
+}
+
+static inline void ring_prep_openat(struct io_uring_sqe *sqe, const int dfd, const char *path,
+    const int flags, const mode_t mode, const uint64_t data) {
+    ring_prep(sqe, IORING_OP_OPENAT, dfd, path, mode, 0, data);
+    sqe->open_flags = flags;
+}
+
+static inline void ring_prep_statx(struct io_uring_sqe *sqe, const int dfd, const char *path,
+    const int flags, const unsigned mask, void *statxbuf, const uint64_t data) {
+    ring_prep(sqe, IORING_OP_STATX, dfd, path, mask, (uint64_t) (uintptr_t) statxbuf, data);
+    sqe->statx_flags = flags;
+}
+
+static inline void ring_prep_read(struct io_uring_sqe *sqe, const int fd, void *buf,
+    const unsigned len, const uint64_t off, const uint64_t data) {
+    ring_prep(sqe, IORING_OP_READ, fd, buf, len, off, data);
+}
+
+static inline void ring_prep_write(struct io_uring_sqe *sqe, const int fd, const void *buf,
+    const unsigned len, const uint64_t off, const uint64_t data) {
+    ring_prep(sqe, IORING_OP_WRITE, fd, buf, len, off, data);
+}
+
+static inline void ring_prep_fallocate(struct io_uring_sqe *sqe, const int fd, const int mode,
+    const uint64_t off, const uint64_t len, const uint64_t data) {
+    ring_prep(sqe, IORING_OP_FALLOCATE, fd, (const void *) (uintptr_t) len, mode, off, data);
+}
+
+// cancels the operation linked to it (IOSQE_IO_LINK) if that isn't done within ts, which then
+// completes with -ECANCELED
+static inline void ring_prep_link_timeout(
+    struct io_uring_sqe *sqe, const struct __kernel_timespec *ts, const uint64_t data) {
+    ring_prep(sqe, IORING_OP_LINK_TIMEOUT, -1, ts, 1, 0, data);
+}
+
+static inline void ring_prep_close(struct io_uring_sqe *sqe, const int fd, const uint64_t data) {
+    ring_prep(sqe, IORING_OP_CLOSE, fd, NULL, 0, 0, data);
+}
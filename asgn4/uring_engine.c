@@ -0,0 +1,958 @@
+// struct statx is a Linux extension
+#define _GNU_SOURCE
+
+#include "uring_engine.h"
+
+#include "httpserver.h"
+#include "seb_fdcache.h"
+#include "seb_http.h"
+#include "seb_objcache.h"
+#include "seb_uring.h"
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define _SQ_ENTRIES 1024
+// every connection has at most one operation in flight (and its timeout), this is how many we
+// expect per ring
+#define _CQ_ENTRIES 16384
+// so a ring stops accepting at this many connections, their completions always fit (with the
+// accept's and the wake read's)
+#define _MAX_CONNS ((_CQ_ENTRIES - 2) / 2)
+
+// file data moves through a buffer of this size per connection, only while it is moving
+#define _CHUNK_SIZE (64 * 1024)
+// small buffer for header-only responses to a GET, and for draining the socket before closing
+#define _SMALL_SIZE GET_HEADERS_MAX
+
+// how often a waiting ring checks whether the server is stopping
+#define _WAIT_MS 100
+
+// user_data of the operations that don't belong to a connection
+// connections are identified by their (aligned) address, so these never collide
+#define _UD_ACCEPT 1
+#define _UD_WAKE 2
+#define _UD_TIMEOUT 3
+
+// every receive from a client gives up after this, like the SO_RCVTIMEO of the threads engine
+static const struct __kernel_timespec _recv_timeout = {.tv_sec = REQUEST_TIMEOUT};
+
+typedef struct worker Worker;
+typedef struct uri_lock UriLock;
+
+typedef enum {
+    // reading the request line and headers
+    C_RECV_REQUEST,
+    // waiting for the lock of the URI
+    C_LOCKING,
+    // GET: opening the file
+    C_OPEN,
+    // GET: stat'ing the opened file
+    C_STAT,
+    // PUT: reserving space for the body in the temporary file
+    C_PREALLOCATE,
+    // GET: reading the next chunk of the file
+    C_READ_FILE,
+    // GET: sending the chunk (the first one starts with the headers)
+    C_SEND_FILE,
+    // GET: sending the headers of a response from the object cache
+    C_SEND_HEADERS,
+    // PUT: receiving the next chunk of the body
+    C_RECV_BODY,
+    // PUT: writing the chunk to the file
+    C_WRITE_FILE,
+    // sending a pre-written response
+    C_SEND_RESPONSE,
+    // reading what the client still sends before closing, like req_close
+    C_DRAIN,
+    // closing the socket
+    C_CLOSE,
+} ConnState;
+
+typedef struct conn {
+    // the ring this connection's operations go through
+    Worker *owner;
+    ConnState state;
+
+    int sockfd;
+    Request *req;
+
+    // set once the request is parsed
+    const char *uri;
+    const char *request_id;
+    bool writer;
+
+    // the URI lock, once held or waited for
+    UriLock *lock;
+
+    // the open file, -1 if none
+    int fd;
+    // GET: the file being sent, shared through the fd cache
+    CachedFile *file;
+    // GET: the cached response being sent instead, PUT: the new one to write through
+    CachedObject *obj;
+    // PUT: the temporary file the body is received into
+    char tmp[PUT_TEMP_SIZE];
+
+    // where the next file operation is at, and how many bytes of the file or body are left
+    // for a 206, the offset and what is left of the current range
+    off_t off;
+    size_t remaining;
+
+    // GET: the ranges of a 206, and the next one to start (count is past the closing boundary
+    // of a multipart body)
+    RangeSet ranges;
+    int part;
+
+    // the data being sent or written: [pos, len) of data is still to go
+    const char *data;
+    size_t pos;
+    size_t len;
+
+    // _CHUNK_SIZE buffer for file data, allocated when needed
+    char *buf;
+    char small[_SMALL_SIZE];
+
+    struct statx stx;
+
+    // link in a lock's wait list, or a worker's ready list
+    struct conn *next;
+} Conn;
+
+struct worker {
+    Ring ring;
+    pthread_t thread;
+    int listen_fd;
+    volatile bool *running;
+
+    // the connections of this ring, and whether it is accepting more (see _MAX_CONNS)
+    int conns;
+    bool accepting;
+
+    // connections whose lock was granted by another thread, to be continued on this one
+    pthread_mutex_t ready_mutex;
+    Conn *ready;
+    // written to when ready gains a connection from another thread
+    int wake_fd;
+    uint64_t wake_val;
+};
+
+// per-URI reader/writer locks
+//
+// rwlock_t blocks the caller, which would stall every connection of a ring. Instead, a
+// connection that can't have the lock yet is parked on the lock's wait list, and handed back to
+// its own ring when a release grants it the lock. Waiters are granted in order (as N_WAY).
+
+struct uri_lock {
+    char *uri;
+    int readers;
+    bool writer;
+    // connections holding or waiting for this lock, it is freed when none are left
+    int users;
+
+    Conn *wait_head;
+    Conn *wait_tail;
+
+    struct uri_lock *next;
+};
+
+#define _LOCK_BUCKETS 256
+
+static UriLock *lock_table[_LOCK_BUCKETS];
+static pthread_mutex_t lock_table_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned uri_hash(const char *uri) {
+    // FNV-1a
+    unsigned h = 2166136261u;
+    for (; *uri != '\0'; uri++) {
+        h = (h ^ (unsigned char) *uri) * 16777619u;
+    }
+    return h % _LOCK_BUCKETS;
+}
+
+// hands a connection that was just granted its lock back to its ring
+static void wake(const Worker *self, Conn *c) {
+    Worker *w = c->owner;
+
+    pthread_mutex_lock(&w->ready_mutex);
+    c->next = w->ready;
+    w->ready = c;
+    pthread_mutex_unlock(&w->ready_mutex);
+
+    if (w != self) {
+        const uint64_t one = 1;
+        (void) !write(w->wake_fd, &one, sizeof(one));
+    }
+}
+
+// returns true if the lock was granted right away, otherwise the connection is woken later
+static bool lock_acquire(Conn *c) {
+    pthread_mutex_lock(&lock_table_mutex);
+
+    UriLock **bucket = &lock_table[uri_hash(c->uri)];
+    UriLock *l = *bucket;
+    while (l != NULL && strcmp(l->uri, c->uri) != 0) {
+        l = l->next;
+    }
+
+    if (l == NULL) {
+        l = calloc(1, sizeof(UriLock));
+        l->uri = strdup(c->uri);
+        l->next = *bucket;
+        *bucket = l;
+    }
+
+    l->users++;
+    c->lock = l;
+
+    bool granted = false;
+    if (l->wait_head == NULL && !l->writer && (!c->writer || l->readers == 0)) {
+        granted = true;
+        if (c->writer) {
+            l->writer = true;
+        } else {
+            l->readers++;
+        }
+    } else {
+        c->next = NULL;
+        if (l->wait_tail == NULL) {
+            l->wait_head = c;
+        } else {
+            l->wait_tail->next = c;
+        }
+        l->wait_tail = c;
+    }
+
+    pthread_mutex_unlock(&lock_table_mutex);
+    return granted;
+}
+
+static void lock_release(const Worker *self, Conn *c) {
+    pthread_mutex_lock(&lock_table_mutex);
+
+    UriLock *l = c->lock;
+    if (c->writer) {
+        l->writer = false;
+    } else {
+        l->readers--;
+    }
+
+    // grant the lock to the waiters at the front: one writer, or every reader up to a writer
+    while (l->wait_head != NULL && !l->writer) {
+        Conn *w = l->wait_head;
+        if (w->writer && l->readers > 0) {
+            break;
+        }
+
+        l->wait_head = w->next;
+        if (l->wait_head == NULL) {
+            l->wait_tail = NULL;
+        }
+
+        if (w->writer) {
+            l->writer = true;
+        } else {
+            l->readers++;
+        }
+        wake(self, w);
+    }
+
+    if (--l->users == 0) {
+        UriLock **p = &lock_table[uri_hash(l->uri)];
+        while (*p != l) {
+            p = &(*p)->next;
+        }
+        *p = l->next;
+
+        free(l->uri);
+        free(l);
+    }
+    c->lock = NULL;
+
+    pthread_mutex_unlock(&lock_table_mutex);
+}
+
+// submitting operations
+
+static void submit_accept(Worker *w) {
+    // once full, the other rings take the new connections, or they wait in the backlog
+    w->accepting = w->conns < _MAX_CONNS;
+    if (w->accepting) {
+        ring_prep_accept(ring_get_sqe(&w->ring), w->listen_fd, _UD_ACCEPT);
+    }
+}
+
+static void submit_wake_read(Worker *w) {
+    ring_prep_read(ring_get_sqe(&w->ring), w->wake_fd, &w->wake_val, sizeof(w->wake_val), 0,
+        _UD_WAKE);
+}
+
+// receives from the client, failing with -ECANCELED if nothing comes within _recv_timeout
+static void recv_timed(Conn *c, void *buf, const size_t len) {
+    struct io_uring_sqe *recv, *timeout;
+    ring_get_sqe_pair(&c->owner->ring, &recv, &timeout);
+
+    ring_prep_recv(recv, c->sockfd, buf, len, (uintptr_t) c);
+    recv->flags |= IOSQE_IO_LINK;
+    ring_prep_link_timeout(timeout, &_recv_timeout, _UD_TIMEOUT);
+}
+
+static void recv_request(Conn *c) {
+    bufsize_t space;
+    char *dst = req_read_buf(c->req, &space);
+
+    c->state = C_RECV_REQUEST;
+    recv_timed(c, dst, space);
+}
+
+static void send_data(Conn *c, const ConnState state, const int flags) {
+    c->state = state;
+    ring_prep_send(ring_get_sqe(&c->owner->ring), c->sockfd, c->data + c->pos, c->len - c->pos,
+        MSG_NOSIGNAL | flags, (uintptr_t) c);
+}
+
+// like req_close: tells the client we're done, then reads what it still sends before closing
+static void drain(Conn *c) {
+    // a client that keeps its connection open otherwise never sees the end of the response, and
+    // the receive below waits for it until the timeout
+    shutdown(c->sockfd, SHUT_WR);
+
+    c->state = C_DRAIN;
+    recv_timed(c, c->small, sizeof(c->small));
+}
+
+static void respond_status(Conn *c, const int status) {
+    c->data = canned_response(status, true, &c->len);
+    c->pos = 0;
+    send_data(c, C_SEND_RESPONSE, 0);
+}
+
+static char *conn_buf(Conn *c) {
+    if (c->buf == NULL) {
+        c->buf = malloc(_CHUNK_SIZE);
+    }
+    return c->buf;
+}
+
+// the handlers
+
+// ends the locked part of a request, like the end of the GET/PUT cases in handle_connection
+static void finish_locked(Conn *c, const int status) {
+    write_audit_log(c->writer ? "PUT" : "GET", c->uri, status, c->request_id);
+    lock_release(c->owner, c);
+}
+
+// ends a request that failed before it got the file: logs it and responds
+static void finish_error(Conn *c, const int status) {
+    if (c->fd != -1) {
+        close(c->fd);
+        c->fd = -1;
+    }
+
+    if (c->lock != NULL) {
+        finish_locked(c, status);
+    } else {
+        write_audit_log(c->writer ? "PUT" : "GET", c->uri, status, c->request_id);
+    }
+    respond_status(c, status);
+}
+
+// ends a GET once the file was sent (or the client went away)
+static void get_done(Conn *c) {
+    if (c->obj != NULL) {
+        objcache_release(c->obj);
+        c->obj = NULL;
+    } else {
+        fdcache_release(c->file);
+        c->file = NULL;
+    }
+    drain(c);
+}
+
+// fills in the parts of a struct stat the fd cache users look at
+static void stat_from_statx(struct stat *st, const struct statx *stx) {
+    memset(st, 0, sizeof(*st));
+    st->st_dev = makedev(stx->stx_dev_major, stx->stx_dev_minor);
+    st->st_ino = stx->stx_ino;
+    st->st_mode = stx->stx_mode;
+    st->st_nlink = stx->stx_nlink;
+    st->st_size = stx->stx_size;
+    st->st_blksize = stx->stx_blksize;
+    st->st_mtim.tv_sec = stx->stx_mtime.tv_sec;
+    st->st_mtim.tv_nsec = stx->stx_mtime.tv_nsec;
+}
+
+static void get_read_file(Conn *c) {
+    const size_t room = _CHUNK_SIZE - c->len;
+    const size_t want = c->remaining < room ? c->remaining : room;
+
+    c->state = C_READ_FILE;
+    ring_prep_read(ring_get_sqe(&c->owner->ring), c->file->fd, c->buf + c->len, want, c->off,
+        (uintptr_t) c);
+}
+
+// whether more of the body follows what is in the buffer
+static bool get_more(const Conn *c) {
+    const bool multipart = c->ranges.count > 1;
+    return c->remaining > 0 || c->part < c->ranges.count
+        || (multipart && c->part == c->ranges.count);
+}
+
+static void get_send_file(Conn *c) {
+    // tell the stack more is coming, so the headers and small chunks don't go out on their own
+    send_data(c, C_SEND_FILE, get_more(c) ? MSG_MORE : 0);
+}
+
+// fills the buffer with what comes next of the body, then sends it
+// the body is the rest of the current range, then the part header and data of every next range,
+// then the closing boundary of a multipart body
+static void get_continue(Conn *c) {
+    const struct stat *st = c->obj != NULL ? &c->obj->st : &c->file->st;
+
+    while (true) {
+        const size_t room = _CHUNK_SIZE - c->len;
+
+        if (c->remaining > 0) {
+            if (room == 0) {
+                break;
+            }
+            if (c->obj == NULL) {
+                get_read_file(c);
+                return;
+            }
+
+            const char *body = c->obj->data + c->obj->len - c->obj->st.st_size;
+            const size_t n = c->remaining < room ? c->remaining : room;
+            memcpy(c->buf + c->len, body + c->off, n);
+            c->len += n;
+            c->off += n;
+            c->remaining -= n;
+        } else if (get_more(c) && room >= GET_PART_HEADER_MAX) {
+            const bool multipart = c->ranges.count > 1;
+            if (c->part < c->ranges.count) {
+                const ByteRange *r = &c->ranges.r[c->part];
+                if (multipart) {
+                    c->len += get_part_header(c->buf + c->len, room, st, r);
+                }
+                c->off = r->first;
+                c->remaining = r->last - r->first + 1;
+            } else {
+                c->len += get_parts_end(c->buf + c->len, room);
+            }
+            c->part++;
+        } else {
+            break;
+        }
+    }
+
+    if (c->pos < c->len) {
+        get_send_file(c);
+    } else {
+        get_done(c);
+    }
+}
+
+// sends a complete response from the object cache
+// the headers cached with it don't say the connection closes, ours go first in their place
+static void get_send_object(Conn *c) {
+    c->data = c->small;
+    c->pos = 0;
+    c->len = get_headers(c->small, sizeof(c->small), 200, &c->obj->st, NULL, true);
+    c->remaining = 0;
+    send_data(c, C_SEND_HEADERS, MSG_MORE);
+}
+
+// answers a GET once its object or its file is at hand, still holding the lock
+static void get_start(Conn *c) {
+    if (c->obj == NULL) {
+        // keep small files in memory for the next GETs, while the lock still keeps PUTs out
+        // this reads the file on the ring thread, but only small files that are likely cached
+        c->obj = object_from_file(c->file->fd, &c->file->st);
+        if (c->obj != NULL) {
+            objcache_insert(c->uri, c->obj);
+            fdcache_release(c->file);
+            c->file = NULL;
+        }
+    }
+
+    const struct stat *st = c->obj != NULL ? &c->obj->st : &c->file->st;
+    const int status = get_decide(c->req, st, &c->ranges);
+
+    // the file is open, a PUT from now on renames a new file over it and leaves ours be
+    finish_locked(c, status);
+
+    c->pos = 0;
+    c->off = 0;
+    c->remaining = 0;
+    c->part = 0;
+
+    if (status == 304 || status == 416) {
+        // only headers go back: the validators, or the size of the file
+        c->data = c->small;
+        c->len = get_headers(c->small, sizeof(c->small), status, st, NULL, true);
+        get_send_file(c);
+        return;
+    }
+
+    if (status == 200 && c->obj != NULL) {
+        get_send_object(c);
+        return;
+    }
+
+    // the headers go at the front of the first chunk, so they are sent with the start of the body
+    c->data = conn_buf(c);
+    c->len = get_headers(c->buf, _CHUNK_SIZE, status, st, &c->ranges, true);
+    if (status == 200) {
+        c->remaining = c->file->st.st_size;
+    }
+    get_continue(c);
+}
+
+// replaces the file with the received body, once the writer lock is held
+static void put_publish_locked(Conn *c) {
+    const int status = put_publish(c->tmp, c->uri, c->obj);
+    finish_locked(c, status);
+
+    if (c->obj != NULL) {
+        objcache_release(c->obj);
+        c->obj = NULL;
+    }
+    respond_status(c, status);
+}
+
+// the whole body is in the temporary file (status 0), or it isn't and status is the error
+// like put_receive: 400 if the client stopped short of its content length, 500 if a write failed
+static void put_received(Conn *c, const int status) {
+    // small files go straight into the object cache once published
+    struct stat st;
+    if (status == 0 && fstat(c->fd, &st) == 0) {
+        c->obj = object_from_file(c->fd, &st);
+    }
+
+    close(c->fd);
+    c->fd = -1;
+
+    if (status != 0) {
+        // don't replace the file with part of the body
+        unlink(c->tmp);
+        finish_error(c, status);
+        return;
+    }
+
+    c->state = C_LOCKING;
+    if (lock_acquire(c)) {
+        put_publish_locked(c);
+    }
+}
+
+static void put_write_file(Conn *c) {
+    c->state = C_WRITE_FILE;
+    ring_prep_write(ring_get_sqe(&c->owner->ring), c->fd, c->data + c->pos, c->len - c->pos,
+        c->off, (uintptr_t) c);
+}
+
+static void put_recv_body(Conn *c) {
+    const size_t want = c->remaining < _CHUNK_SIZE ? c->remaining : _CHUNK_SIZE;
+
+    c->state = C_RECV_BODY;
+    recv_timed(c, conn_buf(c), want);
+}
+
+static void put_start(Conn *c) {
+    c->off = 0;
+    c->remaining = req_get_content_length(c->req);
+
+    if (c->remaining == 0) {
+        // no content to write, we're just done here
+        put_received(c, 0);
+        return;
+    }
+
+    // write the body that's already in the buffer first
+    const size_t body_size = req_get_body_size(c->req);
+    if (body_size == 0) {
+        put_recv_body(c);
+        return;
+    }
+
+    c->data = req_get_body(c->req);
+    c->pos = 0;
+    c->len = body_size < c->remaining ? body_size : c->remaining;
+    put_write_file(c);
+}
+
+// receives the body into a temporary file, like put_receive, without holding the lock
+static void put_begin(Conn *c) {
+    const ssize_t content_length = req_get_content_length(c->req);
+    if (content_length < 0) {
+        // the content length is missing or invalid
+        finish_error(c, 400);
+        return;
+    }
+
+    // like put_receive, refused before the body is received
+    const int refused = put_check(c->uri);
+    if (refused != 0) {
+        finish_error(c, refused);
+        return;
+    }
+
+    // creating the file is quick and rare enough to not go through the ring
+    c->fd = put_create_temp(c->tmp);
+    if (c->fd == -1) {
+        finish_error(c, 500);
+        return;
+    }
+
+    if (content_length == 0) {
+        put_start(c);
+        return;
+    }
+
+    // like io_preallocate, KEEP_SIZE so a short body doesn't leave the file padded out
+    c->state = C_PREALLOCATE;
+    ring_prep_fallocate(ring_get_sqe(&c->owner->ring), c->fd, FALLOC_FL_KEEP_SIZE, 0,
+        content_length, (uintptr_t) c);
+}
+
+// continues a request once it holds the lock of its URI
+static void start_locked(Conn *c) {
+    if (c->writer) {
+        put_publish_locked(c);
+        return;
+    }
+
+    // hot small files are answered from memory
+    c->obj = objcache_get(c->uri);
+    if (c->obj != NULL) {
+        get_start(c);
+        return;
+    }
+
+    // hot files are already open
+    c->file = fdcache_get(c->uri);
+    if (c->file != NULL) {
+        get_start(c);
+        return;
+    }
+
+    c->state = C_OPEN;
+    ring_prep_openat(ring_get_sqe(&c->owner->ring), AT_FDCWD, c->uri, O_RDONLY, 0, (uintptr_t) c);
+}
+
+static void dispatch(Conn *c) {
+    c->request_id = req_get_known_header(c->req, HDR_REQUEST_ID);
+    if (c->request_id == NULL) {
+        respond_status(c, 400);
+        return;
+    }
+
+    c->uri = req_get_uri(c->req);
+
+    switch (req_get_method(c->req)) {
+    case GET:
+        c->writer = false;
+        c->state = C_LOCKING;
+        if (lock_acquire(c)) {
+            start_locked(c);
+        }
+        return;
+    case PUT:
+        c->writer = true;
+        put_begin(c);
+        return;
+    default: respond_status(c, 501); return;
+    }
+}
+
+static void conn_free(Conn *c) {
+    Worker *w = c->owner;
+    req_free(c->req);
+    free(c->buf);
+    free(c);
+
+    w->conns--;
+    if (!w->accepting) {
+        submit_accept(w);
+    }
+}
+
+// advances a connection with the result of its operation that just completed
+static void conn_advance(Conn *c, const int res) {
+    switch (c->state) {
+    case C_RECV_REQUEST:
+        if (res <= 0) {
+            // the connection was closed, an error occurred or it timed out (-ECANCELED), consider
+            // this an invalid request
+            respond_status(c, 400);
+            return;
+        }
+
+        switch (req_parse_commit(c->req, res)) {
+        case PARSE_AGAIN: recv_request(c); return;
+        case PARSE_INVALID: respond_status(c, 400); return;
+        case PARSE_DONE: dispatch(c); return;
+        }
+        return;
+
+    case C_OPEN:
+        if (res < 0) {
+            finish_error(c, get_open_error(-res));
+            return;
+        }
+
+        c->fd = res;
+        c->state = C_STAT;
+        ring_prep_statx(ring_get_sqe(&c->owner->ring), c->fd, "", AT_EMPTY_PATH,
+            STATX_BASIC_STATS, &c->stx, (uintptr_t) c);
+        return;
+
+    case C_PREALLOCATE:
+        // only a hint, whether it worked doesn't matter
+        put_start(c);
+        return;
+
+    case C_STAT:
+        if (res < 0) {
+            finish_error(c, get_stat_error(-res));
+        } else if (S_ISDIR(c->stx.stx_mode)) {
+            finish_error(c, 403);
+        } else {
+            struct stat st;
+            stat_from_statx(&st, &c->stx);
+
+            // the cache takes the file over
+            c->file = fdcache_insert(c->uri, c->fd, &st);
+            if (c->file == NULL) {
+                finish_error(c, 500);
+                return;
+            }
+            c->fd = -1;
+            get_start(c);
+        }
+        return;
+
+    case C_READ_FILE:
+        if (res <= 0) {
+            // the file was cut short under us, send what we have and stop there
+            c->remaining = 0;
+            c->ranges.count = c->part = 0;
+        } else {
+            c->len += res;
+            c->off += res;
+            c->remaining -= res;
+        }
+
+        get_continue(c);
+        return;
+
+    case C_SEND_FILE:
+        if (res < 0) {
+            // the client is gone
+            get_done(c);
+            return;
+        }
+
+        c->pos += res;
+        if (c->pos < c->len) {
+            get_send_file(c);
+        } else if (get_more(c)) {
+            c->pos = c->len = 0;
+            get_continue(c);
+        } else {
+            get_done(c);
+        }
+        return;
+
+    case C_SEND_HEADERS:
+        if (res < 0) {
+            get_done(c);
+            return;
+        }
+
+        c->pos += res;
+        if (c->pos < c->len) {
+            send_data(c, C_SEND_HEADERS, MSG_MORE);
+            return;
+        }
+
+        // then the body, from behind the cached headers
+        c->data = c->obj->data + c->obj->len - c->obj->st.st_size;
+        c->pos = 0;
+        c->len = c->obj->st.st_size;
+        get_send_file(c);
+        return;
+
+    case C_RECV_BODY:
+        if (res <= 0) {
+            // closed or timed out (-ECANCELED) before the whole body, the client's fault
+            put_received(c, 400);
+            return;
+        }
+
+        c->data = c->buf;
+        c->pos = 0;
+        c->len = res;
+        put_write_file(c);
+        return;
+
+    case C_WRITE_FILE:
+        if (res <= 0) {
+            put_received(c, 500);
+            return;
+        }
+
+        c->pos += res;
+        c->off += res;
+        if (c->pos < c->len) {
+            put_write_file(c);
+            return;
+        }
+
+        c->remaining -= c->len;
+        if (c->remaining > 0) {
+            put_recv_body(c);
+        } else {
+            put_received(c, 0);
+        }
+        return;
+
+    case C_SEND_RESPONSE:
+        if (res > 0) {
+            c->pos += res;
+            if (c->pos < c->len) {
+                send_data(c, C_SEND_RESPONSE, 0);
+                return;
+            }
+        }
+        drain(c);
+        return;
+
+    case C_DRAIN:
+        c->state = C_CLOSE;
+        ring_prep_close(ring_get_sqe(&c->owner->ring), c->sockfd, (uintptr_t) c);
+        return;
+
+    case C_CLOSE: conn_free(c); return;
+
+    case C_LOCKING:
+        // nothing is in flight while waiting for a lock
+        return;
+    }
+}
+
+static void conn_start(Worker *w, const int sockfd) {
+    Conn *c = calloc(1, sizeof(Conn));
+    w->conns++;
+    c->owner = w;
+    c->sockfd = sockfd;
+    c->req = req_create(sockfd);
+    c->fd = -1;
+
+    recv_request(c);
+}
+
+// continues the connections that were granted their lock
+static void run_ready(Worker *w) {
+    while (true) {
+        pthread_mutex_lock(&w->ready_mutex);
+        Conn *c = w->ready;
+        w->ready = NULL;
+        pthread_mutex_unlock(&w->ready_mutex);
+
+        if (c == NULL) {
+            return;
+        }
+
+        while (c != NULL) {
+            Conn *next = c->next;
+            start_locked(c);
+            c = next;
+        }
+    }
+}
+
+static void *worker_loop(void *arg) {
+    Worker *w = arg;
+
+    submit_accept(w);
+    submit_wake_read(w);
+
+    while (*w->running) {
+        // with the completion queue full (EBUSY), or the kernel short of memory (EAGAIN), reaping
+        // below makes room and the next round submits again
+        if (ring_submit_and_wait(&w->ring, 1, _WAIT_MS) == -1 && errno != EBUSY
+            && errno != EAGAIN) {
+            perror("io_uring_enter");
+            break;
+        }
+
+        struct io_uring_cqe *cqe;
+        while ((cqe = ring_peek_cqe(&w->ring)) != NULL) {
+            const uint64_t user_data = cqe->user_data;
+            const int res = cqe->res;
+            ring_cqe_seen(&w->ring);
+
+            switch (user_data) {
+            case _UD_ACCEPT:
+                if (res >= 0) {
+                    conn_start(w, res);
+                }
+                submit_accept(w);
+                break;
+            case _UD_WAKE: submit_wake_read(w); break;
+            // the receive it belongs to completes on its own, whether the timeout went off or not
+            case _UD_TIMEOUT: break;
+            default: conn_advance((Conn *) (uintptr_t) user_data, res); break;
+            }
+        }
+
+        run_ready(w);
+    }
+
+    return NULL;
+}
+
+int uring_engine_run(const int listen_fd, const int threads, volatile bool *running) {
+    Worker *workers = calloc(threads, sizeof(Worker));
+
+    int started = 0;
+    for (; started < threads; started++) {
+        Worker *w = &workers[started];
+        if (ring_init(&w->ring, _SQ_ENTRIES, _CQ_ENTRIES) == -1) {
+            perror("io_uring_setup");
+            break;
+        }
+
+        w->listen_fd = listen_fd;
+        w->running = running;
+        pthread_mutex_init(&w->ready_mutex, NULL);
+        w->wake_fd = eventfd(0, EFD_CLOEXEC);
+        pthread_create(&w->thread, NULL, worker_loop, w);
+    }
+
+    if (started < threads) {
+        *running = false;
+    }
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        ring_destroy(&workers[i].ring);
+        close(workers[i].wake_fd);
+        pthread_mutex_destroy(&workers[i].ready_mutex);
+    }
+
+    free(workers);
+    return started < threads ? -1 : 0;
+}
@@ -0,0 +1,27 @@
+/**
+ * @file uring_engine.h
+ *
+ * An alternative to the queue + worker thread pool of httpserver.c, chosen with -e uring
+ *
+ * A few threads each run their own io_uring, accepting from the shared listening socket.
+ * Every connection is a state machine advanced by completions: accept, recv, open, stat,
+ * read/write and send all go through the rings, so one thread serves thousands of connections
+ * and many requests share each io_uring_enter. Responses, the audit log and per-URI locking
+ * behave as with the thread pool.
+ *
+ * @author Sebastian Law
+*/
+
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * @brief Serves connections from a listening socket until *running becomes false
+ *
+ * @param listen_fd The listening socket
+ * @param threads The number of threads (and rings) to run
+ * @param running Checked at least every 100ms, set it to false to stop
+ * @return 0 once stopped, -1 if io_uring could not be set up
+*/
+int uring_engine_run(const int listen_fd, const int threads, volatile bool *running);